@@ -0,0 +1,278 @@
+/* atlas.cpp - DMI - 19-10-2026
+
+Copyright (C) 2006-8 David Ingram
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License (version 2) as
+published by the Free Software Foundation. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_image.h>
+#include <SDL/SDL_ttf.h>
+#include <SDL/SDL_gfxPrimitives.h>
+#include <SDL/SDL_rotozoom.h>
+
+#include "datatype.h"
+#include "multitalk.h"
+
+/* The micro level of every slide is kept all the time, so rather than
+	thousands of tiny surfaces scattered over the heap they are packed into
+	a few large pages. Each page is filled in shelves: rows of cells as
+	tall as the first one put on them, taking later cells of about the same
+	height left to right. A slide's micro surface is then a surface sharing
+	the page's pixels (SDL_CreateRGBSurfaceFrom), so it is drawn on, reduced
+	into and blitted from exactly as before. A cell given up is reused by
+	the next one which fits it; a page left mostly empty has its remaining
+	cells moved into the others, and a page left with none is freed. */
+
+const int ATLAS_PAGE = 1024;
+const int MIN_LIVE_FRACTION = 4; // Pages less than 1/4 used are repacked
+
+struct atlas_shelf
+{
+	int y, h;
+	int x; // Where the next cell goes
+};
+
+struct atlas_page;
+
+struct atlas_cell
+{
+	int x, y, w, h; // Space taken on the page, perhaps more than needed
+	atlas_page *page;
+	slide *owner; // NULL if the cell is free; its micro_cell is this
+	SDL_Surface *view;
+};
+
+struct atlas_page
+{
+	SDL_Surface *surface;
+	pvector *shelves, *cells;
+	int shelf_y; // Top of the space below the last shelf
+	long live; // Pixels in use
+};
+
+static pvector *atlas = NULL;
+
+atlas_page *new_page(int w, int h)
+{
+	// Pages stay in system memory, as their pixels are shared:
+	SDL_PixelFormat *fmt = screen->format;
+	atlas_page *p = new atlas_page;
+
+	p->surface = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h,
+			fmt->BitsPerPixel, fmt->Rmask, fmt->Gmask, fmt->Bmask, 0);
+	if(p->surface == NULL)
+		error("SDL_CreateRGBSurface failed on atlas page (%d, %d)\n", w, h);
+	track_surface(p->surface, MEM_ZOOMED);
+	p->shelves = new pvector();
+	p->cells = new pvector();
+	p->shelf_y = 0;
+	p->live = 0;
+	atlas->add(p);
+	return p;
+}
+
+void free_page(int n)
+{
+	atlas_page *p = (atlas_page *)atlas->item(n);
+
+	for(int i = 0; i < p->shelves->count(); i++)
+		delete (atlas_shelf *)p->shelves->item(i);
+	for(int i = 0; i < p->cells->count(); i++)
+		delete (atlas_cell *)p->cells->item(i);
+	delete p->shelves;
+	delete p->cells;
+	free_surface(p->surface);
+	delete p;
+	atlas->del(n);
+}
+
+atlas_cell *new_cell(atlas_page *p, int x, int y, int w, int h)
+{
+	atlas_cell *c = new atlas_cell;
+
+	c->x = x;
+	c->y = y;
+	c->w = w;
+	c->h = h;
+	c->page = p;
+	c->owner = NULL;
+	c->view = NULL;
+	p->cells->add(c);
+	return c;
+}
+
+int fits_height(int room, int h)
+{
+	// Allow a little slack, so that similar slides share shelves:
+	return h <= room && room <= h + h / 4 + 2;
+}
+
+atlas_cell *place_on_page(atlas_page *p, int w, int h)
+{
+	atlas_shelf *s;
+	atlas_cell *c;
+
+	for(int i = 0; i < p->cells->count(); i++)
+	{
+		c = (atlas_cell *)p->cells->item(i);
+		if(c->owner == NULL && w <= c->w && fits_height(c->h, h))
+			return c;
+	}
+	for(int i = 0; i < p->shelves->count(); i++)
+	{
+		s = (atlas_shelf *)p->shelves->item(i);
+		if(fits_height(s->h, h) && s->x + w <= p->surface->w)
+		{
+			c = new_cell(p, s->x, s->y, w, s->h);
+			s->x += w;
+			return c;
+		}
+	}
+	if(p->shelf_y + h > p->surface->h || w > p->surface->w)
+		return NULL;
+	s = new atlas_shelf;
+	s->y = p->shelf_y;
+	s->h = h;
+	s->x = w;
+	p->shelves->add(s);
+	p->shelf_y += h;
+	return new_cell(p, 0, s->y, w, h);
+}
+
+atlas_cell *place_cell(int w, int h, atlas_page *not_on, int allow_new,
+		atlas_page **page)
+{
+	atlas_cell *c;
+	atlas_page *p;
+
+	if(atlas == NULL)
+		atlas = new pvector();
+	for(int i = 0; i < atlas->count(); i++)
+	{
+		p = (atlas_page *)atlas->item(i);
+		if(p == not_on)
+			continue;
+		c = place_on_page(p, w, h);
+		if(c != NULL)
+		{
+			*page = p;
+			return c;
+		}
+	}
+	if(!allow_new)
+		return NULL;
+	// Slides too big for a page get one of their own:
+	p = new_page(w > ATLAS_PAGE ? w : ATLAS_PAGE,
+			h > ATLAS_PAGE ? h : ATLAS_PAGE);
+	*page = p;
+	return place_on_page(p, w, h);
+}
+
+SDL_Surface *cell_view(atlas_page *p, atlas_cell *c, int w, int h)
+{
+	SDL_Surface *page = p->surface;
+	SDL_PixelFormat *fmt = page->format;
+	SDL_Surface *view;
+	Uint8 *pixels;
+
+	pixels = (Uint8 *)page->pixels + c->y * page->pitch +
+			c->x * fmt->BytesPerPixel;
+	view = SDL_CreateRGBSurfaceFrom(pixels, w, h, fmt->BitsPerPixel,
+			page->pitch, fmt->Rmask, fmt->Gmask, fmt->Bmask, 0);
+	if(view == NULL)
+	{
+		error("SDL_CreateRGBSurfaceFrom failed on atlas cell (%d, %d)\n",
+				w, h);
+	}
+	return view;
+}
+
+SDL_Surface *fill_cell(atlas_page *p, atlas_cell *c, SDL_Surface *src,
+		slide *owner)
+{
+	// Copies src into the cell, and returns the surface standing for it
+	c->owner = owner;
+	owner->micro_cell = c;
+	c->view = cell_view(p, c, src->w, src->h);
+	SDL_SetAlpha(src, 0, 0); // Copied as it is, not blended
+	SDL_BlitSurface(src, NULL, c->view, NULL);
+	p->live += (long)src->w * src->h;
+	return c->view;
+}
+
+SDL_Surface *pack_micro(SDL_Surface *micro, slide *owner)
+{
+	// Moves a newly made micro level into the atlas, freeing micro itself
+	atlas_page *p;
+	atlas_cell *c;
+	SDL_Surface *view;
+
+	c = place_cell(micro->w, micro->h, NULL, 1, &p);
+	view = fill_cell(p, c, micro, owner);
+	free_surface(micro);
+	return view;
+}
+
+void repack_page(int n)
+{
+	/* Moves the cells still in use on a page into spare space on the
+		others, and frees the page if that empties it: */
+	atlas_page *p = (atlas_page *)atlas->item(n), *to;
+	atlas_cell *c, *moved;
+	SDL_Surface *old;
+
+	for(int i = 0; i < p->cells->count(); i++)
+	{
+		c = (atlas_cell *)p->cells->item(i);
+		if(c->owner == NULL)
+			continue;
+		old = c->view;
+		moved = place_cell(old->w, old->h, p, 0, &to);
+		if(moved == NULL)
+			return; // The other pages are full; leave it for now
+		c->owner->micro = fill_cell(to, moved, old, c->owner);
+		p->live -= (long)old->w * old->h;
+		SDL_FreeSurface(old);
+		c->owner = NULL;
+		c->view = NULL;
+	}
+	free_page(n);
+}
+
+void free_micro(slide *sl)
+{
+	/* Gives up a slide's cell in the atlas. The slide knows its cell, and
+		the cell its page, so only the few pages are looked through: */
+	atlas_cell *c = sl->micro_cell;
+	atlas_page *p;
+	long quarter;
+
+	if(sl->micro == NULL)
+		return;
+	if(c == NULL || c->view != sl->micro)
+		error("Paranoia: micro level not in the atlas");
+	p = c->page;
+	p->live -= (long)c->view->w * c->view->h;
+	SDL_FreeSurface(c->view);
+	c->owner = NULL;
+	c->view = NULL;
+	sl->micro = NULL;
+	sl->micro_cell = NULL;
+	quarter = (long)p->surface->w * p->surface->h / MIN_LIVE_FRACTION;
+	for(int i = 0; i < atlas->count(); i++)
+	{
+		if(atlas->item(i) != p)
+			continue;
+		if(p->live == 0)
+			free_page(i);
+		else if(atlas->count() > 1 && p->live < quarter)
+			repack_page(i);
+		return;
+	}
+}
@@ -0,0 +1,587 @@
+/* blit.cpp - DMI - 19-10-2026
+
+Copyright (C) 2006-8 David Ingram
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License (version 2) as
+published by the Free Software Foundation. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_image.h>
+#include <SDL/SDL_ttf.h>
+#include <SDL/SDL_gfxPrimitives.h>
+#include <SDL/SDL_rotozoom.h>
+
+#include "datatype.h"
+#include "multitalk.h"
+
+/* Alpha blending for the two cases that SDL 1.2 leaves to its generic
+	per-pixel blitter: pictures with an alpha channel (icons, logos and
+	embedded images) and translucent overlays (pins, the magnifier and the
+	radar), onto XRGB8888 or RGB565 surfaces. Overlays are made in the
+	display's format, so on a 16-bit display they are RGB565 too. Each row
+	is blended by a kernel chosen when first used: SSE2 where the CPU has
+	it, otherwise plain C. All of them mix 8-bit channels with 0-256 alpha
+	and truncate, widening RGB565 pixels first, so the SSE2 kernels and
+	the C they finish each row with give the same result. Anything else is
+	passed on to SDL_BlitSurface(). */
+
+#ifdef SSE2_KERNELS
+#include <emmintrin.h>
+#endif
+
+struct blend_format
+{
+	int rshift, gshift, bshift, ashift; // Of the source's 8-bit channels
+	int alpha; // Per-surface alpha (0-256) if the source has no channel
+};
+
+typedef void (*blend_kernel)(const void *src, void *dst, int n,
+		const blend_format *bf);
+
+inline Uint32 source_alpha(Uint32 s, const blend_format *bf)
+{
+	Uint32 a;
+
+	if(bf->ashift < 0)
+		return bf->alpha;
+	a = (s >> bf->ashift) & 0xFF;
+	return a + (a >> 7); // 0-256
+}
+
+void blend_8888_c(const void *src, void *dst, int n, const blend_format *bf)
+{
+	// Source and destination have their colours in the same places
+	const Uint32 *sp = (const Uint32 *)src;
+	Uint32 *d = (Uint32 *)dst;
+	Uint32 s, a, rb, g;
+
+	for(int i = 0; i < n; i++)
+	{
+		s = sp[i];
+		a = source_alpha(s, bf);
+		if(a == 0)
+			continue;
+		if(a == 256)
+		{
+			d[i] = s;
+			continue;
+		}
+		rb = (((s & 0x00FF00FF) * a + (d[i] & 0x00FF00FF) * (256 - a)) >> 8)
+				& 0x00FF00FF;
+		g = (((s & 0x0000FF00) * a + (d[i] & 0x0000FF00) * (256 - a)) >> 8)
+				& 0x0000FF00;
+		d[i] = rb | g;
+	}
+}
+
+inline Uint32 mix_channel(Uint32 s, Uint32 d, Uint32 a)
+{
+	// 8-bit channels, a is 0-256
+	return (s * a + d * (256 - a)) >> 8;
+}
+
+inline Uint16 mix_565(Uint32 r, Uint32 g, Uint32 b, Uint16 dp, Uint32 a)
+{
+	// Mixes 8-bit r, g, b into the RGB565 pixel dp, widened to 8 bits too
+	Uint32 dr = (dp >> 11) & 0x1F, dg = (dp >> 5) & 0x3F, db = dp & 0x1F;
+
+	dr = (dr << 3) | (dr >> 2);
+	dg = (dg << 2) | (dg >> 4);
+	db = (db << 3) | (db >> 2);
+	return (Uint16)(((mix_channel(r, dr, a) >> 3) << 11) |
+			((mix_channel(g, dg, a) >> 2) << 5) | (mix_channel(b, db, a) >> 3));
+}
+
+void blend_565_c(const void *src, void *dst, int n, const blend_format *bf)
+{
+	const Uint32 *sp = (const Uint32 *)src;
+	Uint16 *d = (Uint16 *)dst;
+	Uint32 s, a;
+
+	for(int i = 0; i < n; i++)
+	{
+		s = sp[i];
+		a = source_alpha(s, bf);
+		if(a == 0)
+			continue;
+		d[i] = mix_565((s >> bf->rshift) & 0xFF, (s >> bf->gshift) & 0xFF,
+				(s >> bf->bshift) & 0xFF, d[i], a);
+	}
+}
+
+void blend_565_565_c(const void *src, void *dst, int n,
+		const blend_format *bf)
+{
+	// An RGB565 overlay, with per-surface alpha
+	const Uint16 *sp = (const Uint16 *)src;
+	Uint16 *d = (Uint16 *)dst;
+	Uint32 r, g, b;
+
+	for(int i = 0; i < n; i++)
+	{
+		r = (sp[i] >> 11) & 0x1F;
+		g = (sp[i] >> 5) & 0x3F;
+		b = sp[i] & 0x1F;
+		d[i] = mix_565((r << 3) | (r >> 2), (g << 2) | (g >> 4),
+				(b << 3) | (b >> 2), d[i], bf->alpha);
+	}
+}
+
+#ifdef SSE2_KERNELS
+
+SSE2_TARGET inline __m128i alpha_lanes(__m128i s, const blend_format *bf)
+{
+	// Each pixel's alpha (0-256) in both 16-bit halves of its 32-bit lane
+	__m128i a;
+
+	if(bf->ashift < 0)
+		return _mm_set1_epi16((short)bf->alpha);
+	a = _mm_and_si128(_mm_srl_epi32(s, _mm_cvtsi32_si128(bf->ashift)),
+			_mm_set1_epi32(0xFF));
+	a = _mm_add_epi32(a, _mm_srli_epi32(a, 7));
+	return _mm_or_si128(a, _mm_slli_epi32(a, 16));
+}
+
+SSE2_TARGET void blend_8888_sse2(const void *src, void *dst, int n,
+		const blend_format *bf)
+{
+	const Uint32 *sp = (const Uint32 *)src;
+	Uint32 *d = (Uint32 *)dst;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(256);
+	__m128i s, dd, a, alo, ahi, lo, hi;
+	int i = 0;
+
+	for(; i + 4 <= n; i += 4)
+	{
+		s = _mm_loadu_si128((const __m128i *)(sp + i));
+		a = alpha_lanes(s, bf);
+		dd = _mm_loadu_si128((const __m128i *)(d + i));
+		alo = _mm_unpacklo_epi32(a, a);
+		ahi = _mm_unpackhi_epi32(a, a);
+		lo = _mm_add_epi16(
+				_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), alo),
+				_mm_mullo_epi16(_mm_unpacklo_epi8(dd, zero),
+				_mm_sub_epi16(full, alo)));
+		hi = _mm_add_epi16(
+				_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), ahi),
+				_mm_mullo_epi16(_mm_unpackhi_epi8(dd, zero),
+				_mm_sub_epi16(full, ahi)));
+		lo = _mm_srli_epi16(lo, 8);
+		hi = _mm_srli_epi16(hi, 8);
+		_mm_storeu_si128((__m128i *)(d + i), _mm_packus_epi16(lo, hi));
+	}
+	blend_8888_c(sp + i, d + i, n - i, bf);
+}
+
+SSE2_TARGET inline __m128i channel(__m128i s0, __m128i s1, int shift)
+{
+	// One 8-bit channel of eight source pixels, as 16-bit lanes
+	__m128i count = _mm_cvtsi32_si128(shift);
+	__m128i mask = _mm_set1_epi32(0xFF);
+
+	return _mm_packs_epi32(_mm_and_si128(_mm_srl_epi32(s0, count), mask),
+			_mm_and_si128(_mm_srl_epi32(s1, count), mask));
+}
+
+SSE2_TARGET inline __m128i mix(__m128i s, __m128i d, __m128i a)
+{
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a),
+			_mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(256), a))), 8);
+}
+
+SSE2_TARGET inline void widen_565(__m128i p, __m128i *r, __m128i *g,
+		__m128i *b)
+{
+	// Eight RGB565 pixels' channels, widened to 8 bits in 16-bit lanes
+	const __m128i m5 = _mm_set1_epi16(0x1F), m6 = _mm_set1_epi16(0x3F);
+
+	*r = _mm_and_si128(_mm_srli_epi16(p, 11), m5);
+	*g = _mm_and_si128(_mm_srli_epi16(p, 5), m6);
+	*b = _mm_and_si128(p, m5);
+	*r = _mm_or_si128(_mm_slli_epi16(*r, 3), _mm_srli_epi16(*r, 2));
+	*g = _mm_or_si128(_mm_slli_epi16(*g, 2), _mm_srli_epi16(*g, 4));
+	*b = _mm_or_si128(_mm_slli_epi16(*b, 3), _mm_srli_epi16(*b, 2));
+}
+
+SSE2_TARGET inline __m128i narrow_565(__m128i r, __m128i g, __m128i b)
+{
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(r, 3), 11),
+			_mm_slli_epi16(_mm_srli_epi16(g, 2), 5)), _mm_srli_epi16(b, 3));
+}
+
+SSE2_TARGET void blend_565_sse2(const void *src, void *dst, int n,
+		const blend_format *bf)
+{
+	const Uint32 *sp = (const Uint32 *)src;
+	Uint16 *d = (Uint16 *)dst;
+	__m128i s0, s1, dd, a, r, g, b, dr, dg, db;
+	int i = 0;
+
+	for(; i + 8 <= n; i += 8)
+	{
+		s0 = _mm_loadu_si128((const __m128i *)(sp + i));
+		s1 = _mm_loadu_si128((const __m128i *)(sp + i + 4));
+		if(bf->ashift < 0)
+			a = _mm_set1_epi16((short)bf->alpha);
+		else
+		{
+			a = channel(s0, s1, bf->ashift);
+			a = _mm_add_epi16(a, _mm_srli_epi16(a, 7));
+		}
+		r = channel(s0, s1, bf->rshift);
+		g = channel(s0, s1, bf->gshift);
+		b = channel(s0, s1, bf->bshift);
+
+		dd = _mm_loadu_si128((const __m128i *)(d + i));
+		widen_565(dd, &dr, &dg, &db);
+		dd = narrow_565(mix(r, dr, a), mix(g, dg, a), mix(b, db, a));
+		_mm_storeu_si128((__m128i *)(d + i), dd);
+	}
+	blend_565_c(sp + i, d + i, n - i, bf);
+}
+
+SSE2_TARGET void blend_565_565_sse2(const void *src, void *dst, int n,
+		const blend_format *bf)
+{
+	const Uint16 *sp = (const Uint16 *)src;
+	Uint16 *d = (Uint16 *)dst;
+	const __m128i a = _mm_set1_epi16((short)bf->alpha);
+	__m128i ss, dd, r, g, b, dr, dg, db;
+	int i = 0;
+
+	for(; i + 8 <= n; i += 8)
+	{
+		ss = _mm_loadu_si128((const __m128i *)(sp + i));
+		dd = _mm_loadu_si128((const __m128i *)(d + i));
+		widen_565(ss, &r, &g, &b);
+		widen_565(dd, &dr, &dg, &db);
+		dd = narrow_565(mix(r, dr, a), mix(g, dg, a), mix(b, db, a));
+		_mm_storeu_si128((__m128i *)(d + i), dd);
+	}
+	blend_565_565_c(sp + i, d + i, n - i, bf);
+}
+
+#endif
+
+int have_sse2()
+{
+	// Whether the SSE2 kernels here and in glyphs.cpp can run on this CPU
+#ifdef SSE2_KERNELS
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+#else
+	return 0;
+#endif
+}
+
+static int kernels_chosen = 0;
+static blend_kernel blend_8888 = blend_8888_c;
+static blend_kernel blend_565 = blend_565_c;
+static blend_kernel blend_565_565 = blend_565_565_c;
+
+void choose_kernels()
+{
+#ifdef SSE2_KERNELS
+	if(have_sse2())
+	{
+		blend_8888 = blend_8888_sse2;
+		blend_565 = blend_565_sse2;
+		blend_565_565 = blend_565_565_sse2;
+	}
+#endif
+	kernels_chosen = 1;
+}
+
+inline int is_565(SDL_PixelFormat *f)
+{
+	return f->BytesPerPixel == 2 && f->Rmask == 0xF800 &&
+			f->Gmask == 0x07E0 && f->Bmask == 0x001F;
+}
+
+int blend_blit(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst,
+		SDL_Rect *dstrect)
+{
+	/* Same arguments and result as SDL_BlitSurface(), except that dstrect
+		isn't updated. */
+	SDL_PixelFormat *sf = src->format, *df = dst->format;
+	SDL_Rect *clip = &dst->clip_rect;
+	blend_format bf;
+	blend_kernel kernel;
+	int sx, sy, w, h, dx, dy;
+	int locked_src = 0, locked_dst = 0;
+
+	if(!(src->flags & SDL_SRCALPHA))
+		return SDL_BlitSurface(src, srcrect, dst, dstrect);
+	if(sf->BytesPerPixel == 4 && df->BytesPerPixel == 4 &&
+			df->Rmask == sf->Rmask && df->Gmask == sf->Gmask &&
+			df->Bmask == sf->Bmask && (df->Gmask == 0x0000FF00) &&
+			(df->Rmask | df->Bmask) == 0x00FF00FF)
+		kernel = blend_8888;
+	else if(!is_565(df))
+		return SDL_BlitSurface(src, srcrect, dst, dstrect);
+	else if(sf->BytesPerPixel == 4)
+		kernel = blend_565;
+	else if(is_565(sf))
+		kernel = blend_565_565;
+	else
+		return SDL_BlitSurface(src, srcrect, dst, dstrect);
+	if(!kernels_chosen)
+		choose_kernels();
+
+	bf.rshift = sf->Rshift;
+	bf.gshift = sf->Gshift;
+	bf.bshift = sf->Bshift;
+	bf.ashift = sf->Amask != 0 ? sf->Ashift : -1;
+	bf.alpha = sf->alpha + (sf->alpha >> 7);
+	if(bf.ashift < 0 && bf.alpha == 256)
+		return SDL_BlitSurface(src, srcrect, dst, dstrect); // Opaque
+
+	// Clip, as SDL_BlitSurface() would:
+	sx = srcrect != NULL ? srcrect->x : 0;
+	sy = srcrect != NULL ? srcrect->y : 0;
+	w = srcrect != NULL ? srcrect->w : src->w;
+	h = srcrect != NULL ? srcrect->h : src->h;
+	dx = dstrect != NULL ? dstrect->x : 0;
+	dy = dstrect != NULL ? dstrect->y : 0;
+	if(sx < 0) { w += sx; dx -= sx; sx = 0; }
+	if(sy < 0) { h += sy; dy -= sy; sy = 0; }
+	if(sx + w > src->w) w = src->w - sx;
+	if(sy + h > src->h) h = src->h - sy;
+	if(dx < clip->x) { w -= clip->x - dx; sx += clip->x - dx; dx = clip->x; }
+	if(dy < clip->y) { h -= clip->y - dy; sy += clip->y - dy; dy = clip->y; }
+	if(dx + w > clip->x + clip->w) w = clip->x + clip->w - dx;
+	if(dy + h > clip->y + clip->h) h = clip->y + clip->h - dy;
+	if(w <= 0 || h <= 0)
+		return 0;
+
+	if(SDL_MUSTLOCK(src))
+	{
+		if(SDL_LockSurface(src) != 0)
+			return -1;
+		locked_src = 1;
+	}
+	if(SDL_MUSTLOCK(dst))
+	{
+		if(SDL_LockSurface(dst) != 0)
+		{
+			if(locked_src)
+				SDL_UnlockSurface(src);
+			return -1;
+		}
+		locked_dst = 1;
+	}
+	for(int row = 0; row < h; row++)
+	{
+		kernel((Uint8 *)src->pixels + (sy + row) * src->pitch +
+				sx * sf->BytesPerPixel,
+				(Uint8 *)dst->pixels + (dy + row) * dst->pitch +
+				dx * df->BytesPerPixel, w, &bf);
+	}
+	if(locked_dst)
+		SDL_UnlockSurface(dst);
+	if(locked_src)
+		SDL_UnlockSurface(src);
+	return 0;
+}
+
+/* Resampling to any scale, for zooming smoothly between the levels of the
+	slide pyramid. Between XRGB8888 surfaces each pixel is interpolated
+	bilinearly from the four nearest, in 16.16 fixed point with two
+	channels per multiply as in blend_8888_c(); anything else is scaled by
+	picking the nearest pixel. Only ever used for ratios under 2:1 either
+	way, as the nearest level is chosen first, so bilinear is enough. */
+
+inline Uint32 lerp_8888(Uint32 a, Uint32 b, Uint32 f)
+{
+	// f is 0-256, the weight of b
+	Uint32 rb, g;
+
+	rb = (((a & 0x00FF00FF) * (256 - f) + (b & 0x00FF00FF) * f) >> 8)
+			& 0x00FF00FF;
+	g = (((a & 0x0000FF00) * (256 - f) + (b & 0x0000FF00) * f) >> 8)
+			& 0x0000FF00;
+	return rb | g;
+}
+
+void sample_axis(int *pos, int *frac, int from, int to, int dst_start,
+		int dst_len, int src_len)
+{
+	/* The source pixel (and the weight of the one after it) sampled for
+		each destination pixel in [from, to), pixel centres lined up: */
+	long step = ((long)src_len << 16) / dst_len;
+	long p;
+
+	for(int i = from; i < to; i++)
+	{
+		p = (i - dst_start) * step + step / 2 - 0x8000;
+		if(p < 0)
+			p = 0;
+		pos[i - from] = (int)(p >> 16);
+		frac[i - from] = (int)((p >> 8) & 0xFF);
+		if(pos[i - from] >= src_len - 1)
+		{
+			pos[i - from] = src_len - 1;
+			frac[i - from] = 0;
+		}
+	}
+}
+
+void scale_rows_8888(SDL_Surface *src, SDL_Surface *dst, int x1, int x2,
+		int y1, int y2, int *sx, int *fx, int *sy, int *fy)
+{
+	Uint32 *r0, *r1, *d;
+	int a, b;
+
+	for(int y = y1; y < y2; y++)
+	{
+		r0 = (Uint32 *)((Uint8 *)src->pixels + sy[y - y1] * src->pitch);
+		r1 = sy[y - y1] + 1 < src->h ?
+				(Uint32 *)((Uint8 *)r0 + src->pitch) : r0;
+		d = (Uint32 *)((Uint8 *)dst->pixels + y * dst->pitch) + x1;
+		for(int x = 0; x < x2 - x1; x++)
+		{
+			a = sx[x];
+			b = a + 1 < src->w ? a + 1 : a;
+			d[x] = lerp_8888(lerp_8888(r0[a], r0[b], fx[x]),
+					lerp_8888(r1[a], r1[b], fx[x]), fy[y - y1]);
+		}
+	}
+}
+
+Uint32 load_pixel(Uint8 *p, int bpp)
+{
+	switch(bpp)
+	{
+		case 1: return *p;
+		case 2: return *(Uint16 *)p;
+		case 3:
+			if(SDL_BYTEORDER == SDL_BIG_ENDIAN)
+				return (p[0] << 16) | (p[1] << 8) | p[2];
+			return p[0] | (p[1] << 8) | (p[2] << 16);
+		default: return *(Uint32 *)p;
+	}
+}
+
+void store_pixel(Uint8 *p, int bpp, Uint32 pixel)
+{
+	switch(bpp)
+	{
+		case 1: *p = (Uint8)pixel; break;
+		case 2: *(Uint16 *)p = (Uint16)pixel; break;
+		case 3:
+			if(SDL_BYTEORDER == SDL_BIG_ENDIAN)
+			{
+				p[0] = (pixel >> 16) & 0xFF;
+				p[1] = (pixel >> 8) & 0xFF;
+				p[2] = pixel & 0xFF;
+			}
+			else
+			{
+				p[0] = pixel & 0xFF;
+				p[1] = (pixel >> 8) & 0xFF;
+				p[2] = (pixel >> 16) & 0xFF;
+			}
+			break;
+		default: *(Uint32 *)p = pixel; break;
+	}
+}
+
+void scale_rows_nearest(SDL_Surface *src, SDL_Surface *dst, int x1, int x2,
+		int y1, int y2, int *sx, int *fx, int *sy, int *fy, int same)
+{
+	int sb = src->format->BytesPerPixel, db = dst->format->BytesPerPixel;
+	Uint8 *row, *d, r, g, b;
+	Uint32 pixel;
+	int a;
+
+	for(int y = y1; y < y2; y++)
+	{
+		a = sy[y - y1];
+		if(fy[y - y1] >= 128 && a + 1 < src->h)
+			a++; // Rounded to the nearest row
+		row = (Uint8 *)src->pixels + a * src->pitch;
+		d = (Uint8 *)dst->pixels + y * dst->pitch + x1 * db;
+		for(int x = 0; x < x2 - x1; x++, d += db)
+		{
+			a = sx[x];
+			if(fx[x] >= 128 && a + 1 < src->w)
+				a++;
+			if(same)
+			{
+				memcpy(d, row + a * sb, db);
+				continue;
+			}
+			pixel = load_pixel(row + a * sb, sb);
+			SDL_GetRGB(pixel, src->format, &r, &g, &b);
+			store_pixel(d, db, SDL_MapRGB(dst->format, r, g, b));
+		}
+	}
+}
+
+int scale_blit(SDL_Surface *src, SDL_Surface *dst, SDL_Rect *dstrect)
+{
+	/* Scales the whole of src to fill dstrect on dst, within dst's clip
+		rectangle. Returns 0, or -1 if a surface couldn't be locked: */
+	SDL_PixelFormat *sf = src->format, *df = dst->format;
+	SDL_Rect *clip = &dst->clip_rect;
+	int x1, y1, x2, y2, same, bilinear;
+	int *sx, *fx, *sy, *fy;
+	int locked_src = 0, locked_dst = 0;
+
+	if(dstrect->w <= 0 || dstrect->h <= 0 || src->w <= 0 || src->h <= 0)
+		return 0;
+	x1 = dstrect->x > clip->x ? dstrect->x : clip->x;
+	y1 = dstrect->y > clip->y ? dstrect->y : clip->y;
+	x2 = dstrect->x + dstrect->w;
+	y2 = dstrect->y + dstrect->h;
+	if(x2 > clip->x + clip->w) x2 = clip->x + clip->w;
+	if(y2 > clip->y + clip->h) y2 = clip->y + clip->h;
+	if(x1 >= x2 || y1 >= y2)
+		return 0;
+	same = sf->BytesPerPixel == df->BytesPerPixel && sf->Rmask == df->Rmask &&
+			sf->Gmask == df->Gmask && sf->Bmask == df->Bmask;
+	bilinear = same && df->BytesPerPixel == 4 && df->Gmask == 0x0000FF00 &&
+			(df->Rmask | df->Bmask) == 0x00FF00FF;
+
+	if(SDL_MUSTLOCK(src))
+	{
+		if(SDL_LockSurface(src) != 0)
+			return -1;
+		locked_src = 1;
+	}
+	if(SDL_MUSTLOCK(dst))
+	{
+		if(SDL_LockSurface(dst) != 0)
+		{
+			if(locked_src)
+				SDL_UnlockSurface(src);
+			return -1;
+		}
+		locked_dst = 1;
+	}
+	sx = new int[x2 - x1];
+	fx = new int[x2 - x1];
+	sy = new int[y2 - y1];
+	fy = new int[y2 - y1];
+	sample_axis(sx, fx, x1, x2, dstrect->x, dstrect->w, src->w);
+	sample_axis(sy, fy, y1, y2, dstrect->y, dstrect->h, src->h);
+	if(bilinear)
+		scale_rows_8888(src, dst, x1, x2, y1, y2, sx, fx, sy, fy);
+	else
+		scale_rows_nearest(src, dst, x1, x2, y1, y2, sx, fx, sy, fy, same);
+	delete[] sx;
+	delete[] fx;
+	delete[] sy;
+	delete[] fy;
+	if(locked_dst)
+		SDL_UnlockSurface(dst);
+	if(locked_src)
+		SDL_UnlockSurface(src);
+	return 0;
+}
@@ -24,6 +24,14 @@ published by the Free Software Foundation. */
 #include "multitalk.h"
 
 static const int WARP_STEPS = 16;
+static const int DISPLAY_DEPTH = 32;
+static const int MEMORY_BUDGET = 0; // Unlimited
+static const int COMPRESS = 1;
+static const int DIRECT_RENDER = 1;
+static const int DIRECT_ZOOM = 0;
+static const int ZOOM_TIME = 200;
+static const int WARP_TIME = 400;
+static const int PRESENT_THREAD = 0;
 
 static const char *LATEX_CMD = "latex";
 static const char *DVIPS_CMD = "dvips";
@@ -70,6 +78,14 @@ Options::Options()
 	dvipscmd = sdup(DVIPS_CMD);
 	convertcmd = sdup(CONVERT_CMD);
 	warpsteps = WARP_STEPS;
+	depth = DISPLAY_DEPTH;
+	memorybudget = MEMORY_BUDGET;
+	compress = COMPRESS;
+	directrender = DIRECT_RENDER;
+	directzoom = DIRECT_ZOOM;
+	zoomtime = ZOOM_TIME;
+	warptime = WARP_TIME;
+	presentthread = PRESENT_THREAD;
 }
 
 void Options::update(dictionary *d)
@@ -78,4 +94,12 @@ void Options::update(dictionary *d)
 	set_string_property(d, "dvipscmd", &dvipscmd);
 	set_string_property(d, "convertcmd", &convertcmd);
 	set_integer_property(d, "warpsteps", &warpsteps);
+	set_integer_property(d, "depth", &depth);
+	set_integer_property(d, "memorybudget", &memorybudget);
+	set_integer_property(d, "compress", &compress);
+	set_integer_property(d, "directrender", &directrender);
+	set_integer_property(d, "directzoom", &directzoom);
+	set_integer_property(d, "zoomtime", &zoomtime);
+	set_integer_property(d, "warptime", &warptime);
+	set_integer_property(d, "presentthread", &presentthread);
 }
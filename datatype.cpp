@@ -584,7 +584,11 @@ int linefile::load(const char *filename)
 			break;
 		
 		if (strncmp(buf, "@include ", 9) == 0) {
-			load(combine_path(get_path(filename), buf + 9));
+			char *dir = get_path(filename);
+			char *include_path = combine_path(dir, buf + 9);
+			load(include_path);
+			delete[] include_path;
+			delete[] dir;
 		}
 		// if(len > 0)
 		v->add(buf);
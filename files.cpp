@@ -264,6 +264,7 @@ Config *init_paths(const char *talk_ref)
 	
 	config->talk_path = replace_extension(talk_ref, "talk");
 	config->graph_path = replace_extension(talk_ref, "graph");
+	config->memory_path = replace_extension(talk_ref, "memory");
 	config->project_dir = get_path(talk_ref);
 	config->latex_dir = replace_extension(talk_ref, "latex");
 	config->html_dir = replace_extension(talk_ref, "html");
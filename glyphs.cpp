@@ -0,0 +1,561 @@
+/* glyphs.cpp - DMI - 19-10-2026
+
+Copyright (C) 2006-8 David Ingram
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License (version 2) as
+published by the Free Software Foundation. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_image.h>
+#include <SDL/SDL_ttf.h>
+#include <SDL/SDL_gfxPrimitives.h>
+#include <SDL/SDL_rotozoom.h>
+
+#include "datatype.h"
+#include "multitalk.h"
+
+#ifdef SSE2_KERNELS
+#include <emmintrin.h>
+#endif
+
+/* All text is drawn from here. Each glyph is rasterised by SDL_ttf once
+	per font, as an 8-bit coverage map packed into a strip shaped atlas
+	belonging to that font, along with its metrics. Drawing a string then
+	just walks the cached advances and blends each glyph's coverage in
+	the text colour straight into the destination surface, in its own
+	pixel format, so there is no intermediate surface per fragment.
+	Pairs are kerned as SDL_ttf kerns them, and measure_text() walks the
+	same advances and kerns, so layout and drawing agree. */
+
+const int ATLAS_WIDTH = 512; // Coverage bytes per atlas row
+const int GLYPH_PAGE = 256; // Glyphs are looked up in pages of this many
+const int KERN_CACHE = 1024; // Kerned pairs remembered per font
+
+#if SDL_VERSIONNUM(SDL_TTF_MAJOR_VERSION, SDL_TTF_MINOR_VERSION, \
+		SDL_TTF_PATCHLEVEL) >= SDL_VERSIONNUM(2, 0, 10)
+#define KERNING // Older versions don't kern at all
+#endif
+
+struct glyph
+{
+	int x, y, w, h; // Coverage map's position in the atlas
+	int left, top; // Offset of the coverage map from the pen position
+	int advance; // -1 until the glyph has been rasterised
+};
+
+struct kern_pair
+{
+	Uint32 pair; // Previous character << 16 | character; 0 if unused
+	int kern;
+};
+
+struct glyph_atlas
+{
+	TTF_Font *font;
+	int ascent, height;
+	int full_height; // Glyphs come as tall as the font (older SDL_ttf)
+	kern_pair *kerns; // KERN_CACHE of them, or NULL until the first pair
+	Uint8 *coverage; // ATLAS_WIDTH bytes per row
+	int rows; // Allocated
+	int shelf_x, shelf_y, shelf_h; // Where the next glyph is packed
+	glyph *page[65536 / GLYPH_PAGE];
+};
+
+static pvector *atlases = NULL;
+static glyph_atlas *last_atlas = NULL;
+
+int probe_glyph_height(TTF_Font *font)
+{
+	/* Older SDL_ttf versions return every glyph as tall as the whole font,
+		with its top at the font's ascent, and newer ones just the glyph's
+		own box. Which of these a font gets is found from a full stop, far
+		shorter than the font unless it comes back padded: */
+	SDL_Color white = { 255, 255, 255, 0 }, black = { 0, 0, 0, 0 };
+	SDL_Surface *s;
+	int full;
+
+	s = TTF_RenderGlyph_Shaded(font, '.', white, black);
+	if(s == NULL)
+		return 0; // No full stop, so go by the metrics
+	full = (s->h == TTF_FontHeight(font));
+	SDL_FreeSurface(s);
+	return full;
+}
+
+glyph_atlas *find_atlas(TTF_Font *font)
+{
+	glyph_atlas *a;
+
+	if(last_atlas != NULL && last_atlas->font == font)
+		return last_atlas;
+	if(atlases == NULL)
+		atlases = new pvector();
+	for(int i = 0; i < atlases->count(); i++)
+	{
+		a = (glyph_atlas *)atlases->item(i);
+		if(a->font == font)
+		{
+			last_atlas = a;
+			return a;
+		}
+	}
+	a = new glyph_atlas;
+	a->font = font;
+	a->ascent = TTF_FontAscent(font);
+	a->height = TTF_FontHeight(font);
+	a->full_height = probe_glyph_height(font);
+	a->kerns = NULL;
+	a->rows = a->height > 0 ? a->height * 4 : 64;
+	a->coverage = new Uint8[ATLAS_WIDTH * a->rows];
+	memset(a->coverage, 0, ATLAS_WIDTH * a->rows);
+	account_bytes(MEM_STYLES, NULL, ATLAS_WIDTH * a->rows);
+	a->shelf_x = a->shelf_y = a->shelf_h = 0;
+	for(int i = 0; i < 65536 / GLYPH_PAGE; i++)
+		a->page[i] = NULL;
+	atlases->add(a);
+	last_atlas = a;
+	return a;
+}
+
+void forget_glyphs(TTF_Font *font)
+{
+	// Called as a font is closed
+	glyph_atlas *a;
+
+	if(atlases == NULL)
+		return;
+	for(int i = 0; i < atlases->count(); i++)
+	{
+		a = (glyph_atlas *)atlases->item(i);
+		if(a->font != font)
+			continue;
+		for(int j = 0; j < 65536 / GLYPH_PAGE; j++)
+			delete[] a->page[j];
+		account_bytes(MEM_STYLES, NULL, -(long)ATLAS_WIDTH * a->rows);
+		delete[] a->coverage;
+		if(a->kerns != NULL)
+		{
+			account_bytes(MEM_STYLES, NULL,
+					-(long)(sizeof(kern_pair) * KERN_CACHE));
+			delete[] a->kerns;
+		}
+		delete a;
+		atlases->del(i);
+		if(last_atlas == a)
+			last_atlas = NULL;
+		return;
+	}
+}
+
+void grow_atlas(glyph_atlas *a, int rows)
+{
+	Uint8 *coverage;
+
+	if(rows <= a->rows)
+		return;
+	if(rows < a->rows * 2)
+		rows = a->rows * 2;
+	coverage = new Uint8[ATLAS_WIDTH * rows];
+	memcpy(coverage, a->coverage, ATLAS_WIDTH * a->rows);
+	memset(coverage + ATLAS_WIDTH * a->rows, 0, ATLAS_WIDTH * (rows - a->rows));
+	account_bytes(MEM_STYLES, NULL, (long)ATLAS_WIDTH * (rows - a->rows));
+	delete[] a->coverage;
+	a->coverage = coverage;
+	a->rows = rows;
+}
+
+void rasterise_glyph(glyph_atlas *a, glyph *g, Uint16 ch)
+{
+	SDL_Color white = { 255, 255, 255, 0 }, black = { 0, 0, 0, 0 };
+	SDL_Surface *s;
+	int minx, maxx, miny, maxy, advance;
+	Uint8 *src;
+
+	g->x = g->y = g->w = g->h = 0;
+	g->left = g->top = 0;
+	if(TTF_GlyphMetrics(a->font, ch, &minx, &maxx, &miny, &maxy,
+			&advance) != 0)
+	{
+		g->advance = 0; // Not in this font
+		return;
+	}
+	g->advance = advance;
+	if(ch == ' ')
+		return;
+
+	/* Shaded rendering on black gives an 8-bit surface whose pixel values
+		are the glyph's coverage: */
+	s = TTF_RenderGlyph_Shaded(a->font, ch, white, black);
+	if(s == NULL)
+		return;
+	if(s->w > ATLAS_WIDTH)
+		error("Glyph %d is too wide for the glyph atlas", ch);
+	if(a->shelf_x + s->w > ATLAS_WIDTH)
+	{
+		// Start a new shelf:
+		a->shelf_y += a->shelf_h;
+		a->shelf_x = 0;
+		a->shelf_h = 0;
+	}
+	grow_atlas(a, a->shelf_y + s->h);
+	g->x = a->shelf_x;
+	g->y = a->shelf_y;
+	g->w = s->w;
+	g->h = s->h;
+	g->left = minx;
+	g->top = a->full_height ? 0 : a->ascent - maxy;
+	a->shelf_x += s->w;
+	if(s->h > a->shelf_h)
+		a->shelf_h = s->h;
+
+	if(SDL_MUSTLOCK(s))
+		SDL_LockSurface(s);
+	src = (Uint8 *)s->pixels;
+	for(int row = 0; row < s->h; row++)
+	{
+		memcpy(a->coverage + (g->y + row) * ATLAS_WIDTH + g->x,
+				src + row * s->pitch, s->w);
+	}
+	if(SDL_MUSTLOCK(s))
+		SDL_UnlockSurface(s);
+	SDL_FreeSurface(s);
+}
+
+glyph *get_glyph(glyph_atlas *a, Uint16 ch)
+{
+	glyph *page = a->page[ch / GLYPH_PAGE];
+	glyph *g;
+
+	if(page == NULL)
+	{
+		page = new glyph[GLYPH_PAGE];
+		for(int i = 0; i < GLYPH_PAGE; i++)
+			page[i].advance = -1;
+		a->page[ch / GLYPH_PAGE] = page;
+	}
+	g = page + ch % GLYPH_PAGE;
+	if(g->advance < 0)
+		rasterise_glyph(a, g, ch);
+	return g;
+}
+
+Uint16 next_char(const char **s)
+{
+	// Decodes one UTF-8 character (from the Basic Multilingual Plane)
+	const unsigned char *p = (const unsigned char *)*s;
+	Uint16 ch;
+
+	if(p[0] < 0x80)
+	{
+		*s += 1;
+		return p[0];
+	}
+	if((p[0] & 0xE0) == 0xC0 && (p[1] & 0xC0) == 0x80)
+	{
+		*s += 2;
+		return ((p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+	}
+	if((p[0] & 0xF0) == 0xE0 && (p[1] & 0xC0) == 0x80 &&
+			(p[2] & 0xC0) == 0x80)
+	{
+		*s += 3;
+		return ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+	}
+	// Malformed, or outside the BMP: skip the lead byte and continuations
+	ch = 0xFFFD;
+	*s += 1;
+	while((**s & 0xC0) == 0x80)
+		*s += 1;
+	return ch;
+}
+
+char *put_char(char *p, Uint16 ch)
+{
+	// Encodes ch as UTF-8, returning the byte after it
+	if(ch < 0x80)
+		*p++ = (char)ch;
+	else if(ch < 0x800)
+	{
+		*p++ = (char)(0xC0 | (ch >> 6));
+		*p++ = (char)(0x80 | (ch & 0x3F));
+	}
+	else
+	{
+		*p++ = (char)(0xE0 | (ch >> 12));
+		*p++ = (char)(0x80 | ((ch >> 6) & 0x3F));
+		*p++ = (char)(0x80 | (ch & 0x3F));
+	}
+	return p;
+}
+
+int pair_kern(glyph_atlas *a, Uint16 prev, Uint16 ch)
+{
+	/* The adjustment to the pen position between prev and ch. SDL_ttf
+		2.0.10 kerns in TTF_SizeUTF8() and its renderers, but its
+		TTF_GetFontKerningSize() takes FreeType glyph indices, which it has
+		no way to look up, so each pair is measured once with kerning on and
+		off instead. Pairs are remembered in a small hashed cache: */
+#ifdef KERNING
+	Uint32 key = ((Uint32)prev << 16) | ch;
+	kern_pair *k;
+	char pair[7], *end;
+	int on, off, h;
+
+	if(prev == 0 || !TTF_GetFontKerning(a->font))
+		return 0;
+	if(a->kerns == NULL)
+	{
+		a->kerns = new kern_pair[KERN_CACHE];
+		memset(a->kerns, 0, sizeof(kern_pair) * KERN_CACHE);
+		account_bytes(MEM_STYLES, NULL, sizeof(kern_pair) * KERN_CACHE);
+	}
+	k = a->kerns + ((key * 2654435761U) >> 16) % KERN_CACHE;
+	if(k->pair == key)
+		return k->kern;
+	end = put_char(put_char(pair, prev), ch);
+	*end = '\0';
+	TTF_SizeUTF8(a->font, pair, &on, &h);
+	TTF_SetFontKerning(a->font, 0);
+	TTF_SizeUTF8(a->font, pair, &off, &h);
+	TTF_SetFontKerning(a->font, 1);
+	k->pair = key;
+	k->kern = on - off;
+	return k->kern;
+#else
+	return 0;
+#endif
+}
+
+int measure_text(TTF_Font *font, const char *s, int *w, int *h)
+{
+	// Replaces TTF_SizeUTF8(), from the cached advances and kerns
+	glyph_atlas *a = find_atlas(font);
+	Uint16 ch, prev = 0;
+	int width = 0;
+
+	while(*s != '\0')
+	{
+		ch = next_char(&s);
+		width += pair_kern(a, prev, ch) + get_glyph(a, ch)->advance;
+		prev = ch;
+	}
+	*w = width;
+	*h = a->height;
+	return 0;
+}
+
+inline Uint32 read_pixel(Uint8 *p, int bpp)
+{
+	if(bpp == 4)
+		return *(Uint32 *)p;
+	if(bpp == 2)
+		return *(Uint16 *)p;
+	if(SDL_BYTEORDER == SDL_BIG_ENDIAN)
+		return (p[0] << 16) | (p[1] << 8) | p[2];
+	return p[0] | (p[1] << 8) | (p[2] << 16);
+}
+
+inline void write_pixel(Uint8 *p, int bpp, Uint32 pixel)
+{
+	if(bpp == 4)
+		*(Uint32 *)p = pixel;
+	else if(bpp == 2)
+		*(Uint16 *)p = (Uint16)pixel;
+	else if(SDL_BYTEORDER == SDL_BIG_ENDIAN)
+	{
+		p[0] = (pixel >> 16) & 0xFF;
+		p[1] = (pixel >> 8) & 0xFF;
+		p[2] = pixel & 0xFF;
+	}
+	else
+	{
+		p[0] = pixel & 0xFF;
+		p[1] = (pixel >> 8) & 0xFF;
+		p[2] = (pixel >> 16) & 0xFF;
+	}
+}
+
+inline Uint32 blend_channel(Uint32 d, Uint32 s, Uint32 mask, int shift,
+		Uint32 alpha)
+{
+	// alpha is 0-256
+	Uint32 dc = (d & mask) >> shift, sc = (s & mask) >> shift;
+	return (((sc * alpha + dc * (256 - alpha)) >> 8) << shift) & mask;
+}
+
+typedef void (*glyph_kernel)(const Uint8 *cov, Uint8 *dst, int n,
+		Uint32 pixel, SDL_PixelFormat *fmt);
+
+void glyph_row_c(const Uint8 *cov, Uint8 *dst, int n, Uint32 pixel,
+		SDL_PixelFormat *fmt)
+{
+	// Any pixel format, a channel at a time
+	int bpp = fmt->BytesPerPixel;
+	Uint32 rgb = fmt->Rmask | fmt->Gmask | fmt->Bmask;
+	Uint32 d, alpha;
+
+	for(int i = 0; i < n; i++, dst += bpp)
+	{
+		if(cov[i] == 0)
+			continue;
+		if(cov[i] == 255)
+		{
+			write_pixel(dst, bpp, pixel);
+			continue;
+		}
+		alpha = cov[i] + (cov[i] >> 7); // 0-256
+		d = read_pixel(dst, bpp);
+		d = (d & ~rgb) |
+				blend_channel(d, pixel, fmt->Rmask, fmt->Rshift, alpha) |
+				blend_channel(d, pixel, fmt->Gmask, fmt->Gshift, alpha) |
+				blend_channel(d, pixel, fmt->Bmask, fmt->Bshift, alpha);
+		write_pixel(dst, bpp, d);
+	}
+}
+
+void glyph_row_8888_c(const Uint8 *cov, Uint8 *dst, int n, Uint32 pixel,
+		SDL_PixelFormat *fmt)
+{
+	// Channels in bytes 0 and 2 with green between are blended two at once
+	Uint32 *d = (Uint32 *)dst;
+	Uint32 rb, gg, alpha;
+
+	(void)fmt;
+	for(int i = 0; i < n; i++)
+	{
+		if(cov[i] == 0)
+			continue;
+		if(cov[i] == 255)
+		{
+			d[i] = pixel;
+			continue;
+		}
+		alpha = cov[i] + (cov[i] >> 7); // 0-256
+		rb = (((pixel & 0x00FF00FF) * alpha +
+				(d[i] & 0x00FF00FF) * (256 - alpha)) >> 8) & 0x00FF00FF;
+		gg = (((pixel & 0x0000FF00) * alpha +
+				(d[i] & 0x0000FF00) * (256 - alpha)) >> 8) & 0x0000FF00;
+		d[i] = (d[i] & 0xFF000000) | rb | gg;
+	}
+}
+
+#ifdef SSE2_KERNELS
+
+SSE2_TARGET void glyph_row_8888_sse2(const Uint8 *cov, Uint8 *dst, int n,
+		Uint32 pixel, SDL_PixelFormat *fmt)
+{
+	/* Four pixels at a time, as blend_8888_sse2() in blit.cpp, giving the
+		same result as glyph_row_8888_c(): */
+	Uint32 *d = (Uint32 *)dst;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(256);
+	const __m128i colour = _mm_unpacklo_epi8(_mm_set1_epi32(pixel), zero);
+	const __m128i solid = _mm_set1_epi32(pixel);
+	const __m128i unused = _mm_set1_epi32(0xFF000000);
+	__m128i c, a, alo, ahi, dd, lo, hi, out, opaque;
+	Uint32 four;
+	int i = 0;
+
+	for(; i + 4 <= n; i += 4)
+	{
+		memcpy(&four, cov + i, 4);
+		if(four == 0)
+			continue;
+		c = _mm_unpacklo_epi8(_mm_cvtsi32_si128(four), zero);
+		a = _mm_add_epi16(c, _mm_srli_epi16(c, 7)); // 0-256
+		c = _mm_unpacklo_epi16(c, zero); // Coverage in 32-bit lanes
+		a = _mm_unpacklo_epi16(a, a);
+		alo = _mm_unpacklo_epi32(a, a);
+		ahi = _mm_unpackhi_epi32(a, a);
+		dd = _mm_loadu_si128((const __m128i *)(d + i));
+		lo = _mm_add_epi16(_mm_mullo_epi16(colour, alo),
+				_mm_mullo_epi16(_mm_unpacklo_epi8(dd, zero),
+				_mm_sub_epi16(full, alo)));
+		hi = _mm_add_epi16(_mm_mullo_epi16(colour, ahi),
+				_mm_mullo_epi16(_mm_unpackhi_epi8(dd, zero),
+				_mm_sub_epi16(full, ahi)));
+		out = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+		out = _mm_or_si128(_mm_andnot_si128(unused, out),
+				_mm_and_si128(unused, dd));
+		opaque = _mm_cmpeq_epi32(c, _mm_set1_epi32(255));
+		out = _mm_or_si128(_mm_and_si128(opaque, solid),
+				_mm_andnot_si128(opaque, out));
+		_mm_storeu_si128((__m128i *)(d + i), out);
+	}
+	glyph_row_8888_c(cov + i, (Uint8 *)(d + i), n - i, pixel, fmt);
+}
+
+#endif
+
+static int glyph_kernel_chosen = 0;
+static glyph_kernel glyph_row_8888 = glyph_row_8888_c;
+
+void blend_glyph(SDL_Surface *surface, glyph_atlas *a, glyph *g,
+		int x, int y, Uint32 pixel)
+{
+	SDL_PixelFormat *fmt = surface->format;
+	SDL_Rect *clip = &surface->clip_rect;
+	int bpp = fmt->BytesPerPixel;
+	int x1 = x, y1 = y, x2 = x + g->w, y2 = y + g->h;
+	glyph_kernel kernel = glyph_row_c;
+
+	if(!glyph_kernel_chosen)
+	{
+#ifdef SSE2_KERNELS
+		if(have_sse2())
+			glyph_row_8888 = glyph_row_8888_sse2;
+#endif
+		glyph_kernel_chosen = 1;
+	}
+	if(bpp == 4 && (fmt->Rmask | fmt->Gmask | fmt->Bmask) == 0x00FFFFFF &&
+			fmt->Gmask == 0xFF00)
+		kernel = glyph_row_8888;
+	if(x1 < clip->x) x1 = clip->x;
+	if(y1 < clip->y) y1 = clip->y;
+	if(x2 > clip->x + clip->w) x2 = clip->x + clip->w;
+	if(y2 > clip->y + clip->h) y2 = clip->y + clip->h;
+	if(x1 >= x2)
+		return;
+	for(int row = y1; row < y2; row++)
+	{
+		kernel(a->coverage + (g->y + row - y) * ATLAS_WIDTH + g->x + x1 - x,
+				(Uint8 *)surface->pixels + row * surface->pitch + x1 * bpp,
+				x2 - x1, pixel, fmt);
+	}
+}
+
+int draw_text(const char *s, TTF_Font *font, SDL_Color *col,
+		SDL_Surface *surface, int x, int y)
+{
+	// Draws s with its top left at (x, y); returns the x after the text
+	glyph_atlas *a = find_atlas(font);
+	Uint32 pixel = SDL_MapRGB(surface->format, col->r, col->g, col->b);
+	glyph *g;
+	Uint16 ch, prev = 0;
+	int locked = 0;
+
+	if(SDL_MUSTLOCK(surface))
+	{
+		if(SDL_LockSurface(surface) != 0)
+			error("Couldn't lock surface to draw text: %s\n", SDL_GetError());
+		locked = 1;
+	}
+	while(*s != '\0')
+	{
+		ch = next_char(&s);
+		x += pair_kern(a, prev, ch);
+		g = get_glyph(a, ch);
+		if(g->w > 0)
+			blend_glyph(surface, a, g, x + g->left, y + g->top, pixel);
+		x += g->advance;
+		prev = ch;
+	}
+	if(locked)
+		SDL_UnlockSurface(surface);
+	return x;
+}
@@ -230,6 +230,7 @@ SDL_Surface *gen_latex(svector *tex, style *st)
 	}
 		
 	SDL_Surface *surface = load_local_png(pngfilename, 1);
+	track_surface(surface, MEM_LATEX);
 	
 	ret = chdir(current_dir);
 	if(ret != 0)
@@ -0,0 +1,595 @@
+/* memory.cpp - DMI - 19-10-2026
+
+Copyright (C) 2006-8 David Ingram
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License (version 2) as
+published by the Free Software Foundation. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/time.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_image.h>
+#include <SDL/SDL_ttf.h>
+#include <SDL/SDL_gfxPrimitives.h>
+#include <SDL/SDL_rotozoom.h>
+
+#include "datatype.h"
+#include "multitalk.h"
+
+/* Every slide keeps a pyramid of bitmaps: render (design resolution),
+	tiles (screen resolution, only made as they come into view and not
+	needed at all if the two resolutions are the same), mini (1/3) and
+	micro (1/9), plus card stack decorations at full and mini size.
+	When options->memorybudget is set, the full resolution and mini levels
+	of slides which aren't needed for the current view are discarded,
+	furthest from the centre of the view first, and re-rasterised when
+	they are next drawn. The micro level is always kept, so the overview
+	and the radar never need to re-render anything; it lives in the pages
+	of a shared atlas (atlas.cpp), which are counted as a whole rather
+	than against each slide.
+	
+	If options->compress is set, the full resolution level goes through a
+	middle tier first: it is run-length encoded and expanded again when
+	needed, which is much quicker than rendering the slide from scratch.
+	Compressed data is only discarded if that alone isn't enough.
+	
+	All long-lived surfaces are registered here with a category and (where
+	there is one) the slide they belong to, so memory use can be broken
+	down without going to /proc. Surfaces from alloc_surface() and
+	zoom_surface() are registered automatically, others with
+	track_surface(); either way they must be released with free_surface(). */
+
+extern Options *options;
+extern slidevector *talk;
+extern int viewx, viewy, zoom_level;
+
+struct eviction_candidate
+{
+	slide *sl;
+	long dist;
+};
+
+struct tracked_surface
+{
+	SDL_Surface *surface;
+	int category;
+	slide *owner;
+	long bytes;
+	tracked_surface *next;
+};
+
+static const int TRACK_BUCKETS = 4096;
+static tracked_surface *track_table[TRACK_BUCKETS];
+static long memory_use[MEM_CATEGORIES];
+
+static const char *category_name[MEM_CATEGORIES] = {
+	"Slides", "Mini/micro", "Decorations", "Latex", "Styles", "Sub-images",
+	"Compressed", "OSD"
+};
+
+// Compression statistics, for the OSD:
+static long pack_usec = 0, unpack_usec = 0;
+static int packs = 0, unpacks = 0;
+
+// Prototypes:
+int compare_candidates(const void *a, const void *b);
+
+long surface_bytes(SDL_Surface *surface)
+{
+	if(surface == NULL)
+		return 0;
+	return (long)surface->pitch * (long)surface->h;
+}
+
+void account_bytes(int category, slide *owner, long bytes)
+{
+	memory_use[category] += bytes;
+	if(owner != NULL)
+		owner->memory[category] += bytes;
+}
+
+int track_hash(SDL_Surface *surface)
+{
+	return (int)(((unsigned long)surface >> 4) % TRACK_BUCKETS);
+}
+
+tracked_surface *untrack_surface(SDL_Surface *surface)
+{
+	// Removes the entry and returns it (to be deleted by the caller):
+	tracked_surface **link = &track_table[track_hash(surface)];
+	tracked_surface *t;
+
+	for(t = *link; t != NULL; link = &t->next, t = t->next)
+	{
+		if(t->surface == surface)
+		{
+			*link = t->next;
+			account_bytes(t->category, t->owner, -t->bytes);
+			return t;
+		}
+	}
+	return NULL;
+}
+
+void track_surface(SDL_Surface *surface, int category, slide *owner)
+{
+	// Re-registering a surface moves it to the new category/owner
+	tracked_surface *t;
+	int h;
+
+	if(surface == NULL)
+		return;
+	t = untrack_surface(surface);
+	if(t == NULL)
+		t = new tracked_surface;
+	h = track_hash(surface);
+	t->surface = surface;
+	t->category = category;
+	t->owner = owner;
+	t->bytes = surface_bytes(surface);
+	t->next = track_table[h];
+	track_table[h] = t;
+	account_bytes(category, owner, t->bytes);
+}
+
+void free_surface(SDL_Surface *surface)
+{
+	tracked_surface *t;
+
+	if(surface == NULL)
+		return;
+	t = untrack_surface(surface);
+	if(t != NULL)
+		delete t;
+	SDL_FreeSurface(surface);
+}
+
+SDL_Surface *zoom_surface(SDL_Surface *src, double f, int category,
+		slide *owner)
+{
+	SDL_Surface *surface;
+
+	surface = zoomSurface(src, f, f, 1);
+	if(surface == NULL)
+		error("zoomSurface returned NULL");
+	track_surface(surface, category, owner);
+	return surface;
+}
+
+long memory_used(int category)
+{
+	return memory_use[category];
+}
+
+long decoration_bytes(decorations *d)
+{
+	return surface_bytes(d->top) + surface_bytes(d->bottom) +
+			surface_bytes(d->left) + surface_bytes(d->right);
+}
+
+long tile_bytes(slide *sl)
+{
+	long bytes = 0;
+
+	if(sl->tiles == NULL)
+		return 0;
+	for(int i = 0; i < sl->tiles->cols * sl->tiles->rows; i++)
+		bytes += surface_bytes(sl->tiles->tile[i]);
+	return bytes;
+}
+
+long full_bytes(slide *sl)
+{
+	return surface_bytes(sl->render) + tile_bytes(sl) +
+			decoration_bytes(&sl->decor);
+}
+
+long mini_bytes(slide *sl)
+{
+	return surface_bytes(sl->mini) + decoration_bytes(&sl->mini_decor);
+}
+
+long packed_bytes(slide *sl)
+{
+	packed_level *p = sl->packed;
+	long bytes = 0;
+
+	if(p == NULL)
+		return 0;
+	if(p->render != NULL) bytes += p->render->bytes;
+	if(p->top != NULL) bytes += p->top->bytes;
+	if(p->bottom != NULL) bytes += p->bottom->bytes;
+	if(p->left != NULL) bytes += p->left->bytes;
+	if(p->right != NULL) bytes += p->right->bytes;
+	return bytes;
+}
+
+long talk_bytes()
+{
+	// Everything the memory budget applies to:
+	return memory_use[MEM_SLIDES] + memory_use[MEM_ZOOMED] +
+			memory_use[MEM_DECORATIONS] + memory_use[MEM_PACKED];
+}
+
+void free_decoration_set(decorations *d)
+{
+	if(d->top != NULL)
+		free_surface(d->top);
+	if(d->bottom != NULL)
+		free_surface(d->bottom);
+	if(d->left != NULL)
+		free_surface(d->left);
+	if(d->right != NULL)
+		free_surface(d->right);
+	d->top = d->bottom = d->left = d->right = NULL;
+}
+
+void evict_full(slide *sl)
+{
+	// Discard the design and screen resolution bitmaps:
+	free_tiles(sl);
+	if(sl->render != NULL)
+		free_surface(sl->render);
+	sl->render = NULL;
+	free_decoration_set(&sl->decor);
+}
+
+long drop_hidden_tiles(slide *sl)
+{
+	/* Screen resolution tiles are quick to make again from the render
+		surface (or for a tiled slide to draw again), so any off screen are
+		the first thing to go. Returns the
+		number of bytes freed. */
+	slide_tiles *t = sl->tiles;
+	SDL_Surface *tile;
+	long bytes = 0;
+	int x, y;
+
+	if(t == NULL)
+		return 0;
+	for(int row = 0; row < t->rows; row++)
+	{
+		for(int col = 0; col < t->cols; col++)
+		{
+			tile = t->tile[row * t->cols + col];
+			if(tile == NULL)
+				continue;
+			x = sl->x + col * TILE_SIZE;
+			y = sl->y + row * TILE_SIZE;
+			if(zoom_level == 0 && x + tile->w > viewx &&
+					x < viewx + SCREEN_WIDTH && y + tile->h > viewy &&
+					y < viewy + SCREEN_HEIGHT)
+				continue;
+			bytes += surface_bytes(tile);
+			free_surface(tile);
+			t->tile[row * t->cols + col] = NULL;
+		}
+	}
+	return bytes;
+}
+
+void evict_mini(slide *sl)
+{
+	if(sl->mini != NULL)
+		free_surface(sl->mini);
+	sl->mini = NULL;
+	free_decoration_set(&sl->mini_decor);
+}
+
+long elapsed_usec(struct timeval *start)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000L +
+			(now.tv_usec - start->tv_usec);
+}
+
+packed_surface *pack_if_present(SDL_Surface *surface)
+{
+	if(surface == NULL)
+		return NULL;
+	return pack_surface(surface);
+}
+
+SDL_Surface *unpack_if_present(packed_surface *packed)
+{
+	if(packed == NULL)
+		return NULL;
+	return unpack_surface(packed);
+}
+
+void discard_packed(slide *sl)
+{
+	packed_level *p = sl->packed;
+
+	if(p == NULL)
+		return;
+	account_bytes(MEM_PACKED, sl, -packed_bytes(sl));
+	free_packed_surface(p->render);
+	free_packed_surface(p->top);
+	free_packed_surface(p->bottom);
+	free_packed_surface(p->left);
+	free_packed_surface(p->right);
+	delete p;
+	sl->packed = NULL;
+}
+
+void pack_full(slide *sl)
+{
+	packed_level *p;
+	struct timeval start;
+
+	if(sl->render == NULL)
+		return;
+	gettimeofday(&start, NULL);
+	discard_packed(sl);
+	p = new packed_level;
+	p->raw_bytes = full_bytes(sl);
+	p->render = pack_surface(sl->render);
+	p->top = pack_if_present(sl->decor.top);
+	p->bottom = pack_if_present(sl->decor.bottom);
+	p->left = pack_if_present(sl->decor.left);
+	p->right = pack_if_present(sl->decor.right);
+	sl->packed = p;
+	account_bytes(MEM_PACKED, sl, packed_bytes(sl));
+	evict_full(sl);
+	pack_usec += elapsed_usec(&start);
+	packs++;
+}
+
+void unpack_full(slide *sl)
+{
+	packed_level *p = sl->packed;
+	struct timeval start;
+
+	gettimeofday(&start, NULL);
+	evict_full(sl);
+	sl->render = unpack_surface(p->render);
+	track_surface(sl->render, MEM_SLIDES, sl);
+	sl->decor.top = unpack_if_present(p->top);
+	sl->decor.bottom = unpack_if_present(p->bottom);
+	sl->decor.left = unpack_if_present(p->left);
+	sl->decor.right = unpack_if_present(p->right);
+	track_surface(sl->decor.top, MEM_DECORATIONS, sl);
+	track_surface(sl->decor.bottom, MEM_DECORATIONS, sl);
+	track_surface(sl->decor.left, MEM_DECORATIONS, sl);
+	track_surface(sl->decor.right, MEM_DECORATIONS, sl);
+	discard_packed(sl);
+	unpack_usec += elapsed_usec(&start);
+	unpacks++;
+}
+
+void ensure_rendered(slide *sl)
+{
+	/* Restore a slide whose full resolution bitmaps have been evicted,
+		from the compressed copy if there is one. Otherwise re-rasterise,
+		which rebuilds the mini and micro levels as well (cheap by
+		comparison): */
+
+	if(sl->render != NULL)
+		return;
+	if(sl->packed != NULL)
+	{
+		unpack_full(sl);
+		return;
+	}
+	evict_full(sl);
+	if(sl->image_file != NULL)
+	{
+		reallocate_surfaces(sl);
+		load_image(sl);
+	}
+	else
+		render_full(sl);
+}
+
+void ensure_mini(slide *sl)
+{
+	if(sl->mini != NULL)
+		return;
+	if(!zoomed_directly(sl))
+		ensure_rendered(sl); // Mini is reduced from the full size level
+	if(sl->mini != NULL)
+		return;
+	reallocate_surfaces(sl);
+	scale(sl);
+}
+
+int slide_in_view(slide *sl)
+{
+	// Includes the card stack decorations, which extend beyond the slide:
+	int edge = CARD_EDGE * (sl->deck_size - 1);
+	int zf = zoom_factor(zoom_level);
+
+	if(sl->x + sl->scr_w + edge <= viewx || sl->y + sl->scr_h + edge <= viewy)
+		return 0;
+	if(sl->x - edge >= viewx + SCREEN_WIDTH * zf ||
+			sl->y - edge >= viewy + SCREEN_HEIGHT * zf)
+		return 0;
+	return 1;
+}
+
+int compare_candidates(const void *a, const void *b)
+{
+	// Furthest first:
+	long da = ((const eviction_candidate *)a)->dist;
+	long db = ((const eviction_candidate *)b)->dist;
+
+	if(da > db)
+		return -1;
+	if(da < db)
+		return 1;
+	return 0;
+}
+
+void enforce_memory_budget()
+{
+	long budget, bytes, dx, dy;
+	int cx, cy, zf, n;
+	eviction_candidate *candidates;
+	slide *sl;
+
+	if(options->memorybudget <= 0)
+		return;
+	budget = (long)options->memorybudget * 1024L * 1024L;
+	bytes = talk_bytes();
+	if(bytes <= budget)
+		return;
+
+	zf = zoom_factor(zoom_level);
+	cx = viewx + (SCREEN_WIDTH * zf) / 2;
+	cy = viewy + (SCREEN_HEIGHT * zf) / 2;
+	candidates = new eviction_candidate[talk->count()];
+	n = 0;
+	for(int i = 0; i < talk->count(); i++)
+	{
+		sl = talk->item(i);
+		dx = (long)(sl->x + sl->scr_w / 2 - cx);
+		dy = (long)(sl->y + sl->scr_h / 2 - cy);
+		candidates[n].sl = sl;
+		candidates[n].dist = dx * dx + dy * dy;
+		n++;
+	}
+	qsort(candidates, n, sizeof(eviction_candidate), compare_candidates);
+
+	/* Background and texture sheets go first, being made again on demand.
+		The first pass over the slides drops screen resolution tiles which
+		are off screen; the next compresses (or drops) full resolution
+		bitmaps not needed for this zoom level; then mini bitmaps are
+		dropped likewise; the last resort is to drop compressed copies.
+		Micro bitmaps are never evicted: */
+	if(bytes > budget)
+		bytes -= purge_sheets();
+	for(int i = 0; i < n && bytes > budget; i++)
+		bytes -= drop_hidden_tiles(candidates[i].sl);
+	for(int i = 0; i < n && bytes > budget; i++)
+	{
+		sl = candidates[i].sl;
+		if(sl->render == NULL || (zoom_level == 0 && slide_in_view(sl)))
+			continue;
+		if(tiled_slide(sl))
+		{
+			// Drawn whole for a moment; its tiles and card edges stay
+			bytes -= surface_bytes(sl->render);
+			free_surface(sl->render);
+			sl->render = NULL;
+			continue;
+		}
+		bytes -= full_bytes(sl);
+		if(options->compress)
+		{
+			pack_full(sl);
+			bytes += packed_bytes(sl);
+		}
+		else
+			evict_full(sl);
+	}
+	for(int i = 0; i < n && bytes > budget; i++)
+	{
+		sl = candidates[i].sl;
+		if(zoom_level == 1 && slide_in_view(sl))
+			continue;
+		if(sl->render != NULL)
+			continue; // Still needed to draw at zoom level 0
+		bytes -= mini_bytes(sl);
+		evict_mini(sl);
+	}
+	for(int i = 0; i < n && bytes > budget; i++)
+	{
+		sl = candidates[i].sl;
+		bytes -= packed_bytes(sl);
+		discard_packed(sl);
+	}
+	delete[] candidates;
+}
+
+void describe_compression(char *s)
+{
+	// Writes at most 100 chars to s
+	long raw = 0, bytes = 0;
+	int count = 0;
+	slide *sl;
+
+	for(int i = 0; i < talk->count(); i++)
+	{
+		sl = talk->item(i);
+		if(sl->packed == NULL)
+			continue;
+		raw += sl->packed->raw_bytes;
+		bytes += packed_bytes(sl);
+		count++;
+	}
+	sprintf(s, "%d packed, %ldK -> %ldK (%.1f:1), pack %.1fms, unpack %.1fms",
+			count, raw / 1024, bytes / 1024,
+			bytes > 0 ? (double)raw / (double)bytes : 0.0,
+			packs > 0 ? (double)pack_usec / packs / 1000.0 : 0.0,
+			unpacks > 0 ? (double)unpack_usec / unpacks / 1000.0 : 0.0);
+}
+
+void describe_memory(int category, char *s)
+{
+	// Writes at most 40 chars to s
+	sprintf(s, "%s: %.1fM", category_name[category],
+			(double)memory_use[category] / (1024.0 * 1024.0));
+}
+
+void report_memory(int reloads, int vm_size)
+{
+	// One line of totals on stdout, for the -reloadtest soak test
+	long total;
+
+	printf("Reload %d: VM %d", reloads, vm_size);
+	total = 0;
+	for(int c = 0; c < MEM_CATEGORIES; c++)
+	{
+		printf(", %s %ld", category_name[c], memory_use[c]);
+		total += memory_use[c];
+	}
+	printf(", Total %ld\n", total);
+	fflush(stdout);
+}
+
+void dump_memory(const char *path, int vm_size)
+{
+	FILE *fp;
+	slide *sl;
+	long total;
+
+	fp = fopen(path, "w");
+	if(fp == NULL)
+	{
+		printf("Can't write memory report to %s\n", path);
+		return;
+	}
+	fprintf(fp, "Virtual memory size: %d\n\n", vm_size);
+	total = 0;
+	for(int c = 0; c < MEM_CATEGORIES; c++)
+	{
+		fprintf(fp, "%-12s %12ld\n", category_name[c], memory_use[c]);
+		total += memory_use[c];
+	}
+	fprintf(fp, "%-12s %12ld\n\n", "Total", total);
+	
+	fprintf(fp, "Slide");
+	for(int c = 0; c < MEM_CATEGORIES; c++)
+		fprintf(fp, "\t%s", category_name[c]);
+	fprintf(fp, "\n");
+	for(int i = 0; i < talk->count(); i++)
+	{
+		sl = talk->item(i);
+		fprintf(fp, "%s", sl->content->line);
+		if(sl->deck_size > 1)
+			fprintf(fp, " [%d/%d]", sl->card, sl->deck_size);
+		for(int c = 0; c < MEM_CATEGORIES; c++)
+			fprintf(fp, "\t%ld", sl->memory[c]);
+		fprintf(fp, "\n");
+	}
+	fclose(fp);
+	printf("Memory report written to %s\n", path);
+}
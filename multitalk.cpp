@@ -10,6 +10,7 @@ published by the Free Software Foundation. */
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <math.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <pwd.h>
@@ -29,7 +30,7 @@ published by the Free Software Foundation. */
 #include "multitalk.h"
 
 slidevector *talk;
-slidevector *render_list;
+slide_stack *render_list;
 
 stylevector *style_list;
 
@@ -52,6 +53,7 @@ int hover_mode = 1;
 int reverse_mouse = 0;
 int force_latex = 0;
 int export_html = 0;
+int reload_test = 0; // Hidden -reloadtest=n: reload n times, reporting memory
 int pointer_on = 0, pointer_x, pointer_y, hide_pointer = 0;
 char *proc_stat_buf;
 int canvas_colour;
@@ -110,6 +112,10 @@ void refresh(int flip = 1);
 int check_memory();
 void snap_to(int prefx, int prefy);
 void viewloop();
+void get_screen_centre(int *x, int *y);
+int finish_animation();
+void zoom_from(int level);
+SDL_Surface *maximise_picture(slide *sl, int max_w, int max_h);
 
 linefile *open_talk(char *path)
 {
@@ -147,6 +153,7 @@ const char *parse_args(int argc, char **argv)
 {
 	const char *talk_ref;
 	const char *displayopt = "-displaysize=";
+	const char *reloadopt = "-reloadtest=";
 	
 	if(argc < 2)
 		usage();
@@ -169,6 +176,13 @@ const char *parse_args(int argc, char **argv)
 			version();
 		else if(!strcmp(argv[i], "-export"))
 			export_html = 1;
+		else if(!strncmp(argv[i], reloadopt, strlen(reloadopt)))
+		{
+			// -reloadtest=<n>, to check memory stays flat across reloads
+			reload_test = atoi(argv[i] + strlen(reloadopt));
+			if(reload_test < 1)
+				usage();
+		}
 		else if(!strncmp(argv[i], displayopt, strlen(displayopt)))
 		{
 			// -displaysize=<width>x<height>
@@ -210,6 +224,32 @@ int to_design_coords(int x)
 	return x;
 }
 
+int direct_rendering()
+{
+	/* When the display size differs from the design size, slides are
+		normally drawn straight onto screen resolution surfaces, with the
+		fonts, icons and pictures scaled to match, rather than drawn at the
+		design size and resampled. HTML export keeps the design size, to
+		match the image map co-ordinates: */
+	return options->directrender && scalep != 1 && !export_html;
+}
+
+int to_render_coords(int x)
+{
+	// Design co-ordinates to pixels on a slide's render surface
+	if(direct_rendering())
+		return to_screen_coords(x);
+	return x;
+}
+
+double render_zoom()
+{
+	// Factor which takes a slide's render surface to screen resolution
+	if(direct_rendering())
+		return 1.0;
+	return (double)scalep / (double)scaleq;
+}
+
 void set_resolution()
 {
 	/*
@@ -286,7 +326,7 @@ void init_gui(const char *caption, int offscreen)
 	for(int i = 0; i < 3; i++)
 		extra_button[i] = 0;
 	radar = alloc_surface(RADAR_WIDTH, RADAR_HEIGHT);
-	SDL_SetAlpha(radar, SDL_SRCALPHA | SDL_RLEACCEL, 0xCC);
+	SDL_SetAlpha(radar, SDL_SRCALPHA, 0xCC);
 }
 
 void fix_position(int *prefx, int *prefy)
@@ -316,27 +356,60 @@ int zoom_offset(int level)
 void change_zoom_level(int level)
 {
 	int delta = zoom_offset(level) - zoom_offset(zoom_level);
+	int from = zoom_level;
 	
 	if(delta == 0)
 		return;
+	finish_animation(); // A warp's co-ordinates are for this level
 	viewx -= delta * SCREEN_WIDTH;
 	viewy -= delta * SCREEN_HEIGHT;
 	zoom_level = level;
+	zoom_from(from);
 	
 	if(zoom_level == 2)
 	{
 		magnify = slide_under_pointer();
 		if(mag_surface != NULL)
 		{
-			SDL_FreeSurface(mag_surface);
+			free_surface(mag_surface);
 			mag_surface = NULL;
 		}
 	}
 }
 
+#define FRAME_MILLISECONDS 10 // Animation runs at up to 100 frames a second
+#define AUTOSCROLL_PIXELS_PER_SECOND 1600
+
+#ifndef M_PI
+#define M_PI           3.14159265358979323846
+#endif
+
+void pace_frame()
+{
+	// Waits out the rest of the frame, so animation doesn't spin flat out
+	static Uint32 last = 0;
+	Uint32 spent = SDL_GetTicks() - last;
+
+	if(spent < FRAME_MILLISECONDS)
+		SDL_Delay(FRAME_MILLISECONDS - spent);
+	last = SDL_GetTicks();
+}
+
 void autoscroll(int *prefx, int *prefy)
 {
-	const int dist = 16; // This should be >= CARD_EDGE for smoothness
+	/* Moves the view towards (*prefx, *prefy) at a steady speed, however
+		long frames take: as far as it should have gone since the last
+		step, or one frame's worth after a pause: */
+	static Uint32 last = 0;
+	Uint32 now = SDL_GetTicks(), elapsed = now - last;
+	int dist;
+
+	if(elapsed > 10 * FRAME_MILLISECONDS)
+		elapsed = FRAME_MILLISECONDS;
+	last = now;
+	dist = AUTOSCROLL_PIXELS_PER_SECOND * elapsed / 1000;
+	if(dist < 1)
+		dist = 1;
 	
 	if(viewx < *prefx)
 	{
@@ -364,41 +437,136 @@ void autoscroll(int *prefx, int *prefy)
 	}
 }
 
-#define WARP_PIXELS_PER_SECOND 25
-#define WARP_FPS 500
-#define WARP_FRAME_WAIT_MILLISECONDS (1000 / WARP_FPS)
+/* Warps (to another slide, a hyperlink's target, or back again) and
+	zooms between levels are animated by the main loop a frame at a time,
+	not in loops of their own. Each frame depends only on the time since
+	the animation began, so a slow frame is just skipped over, and every
+	warp takes options->warptime (and zoom options->zoomtime) however far
+	it goes. A key pressed meanwhile ends a warp at its destination first;
+	a click stops it where it is. A zoom changes the level at once, and is
+	only animated on the screen, so either just ends it. */
+enum AnimationKind { ANIMATION_NONE, ANIMATION_WARP, ANIMATION_ZOOM };
 
-#include <math.h>
-#ifndef M_PI
-#define M_PI           3.14159265358979323846
-#endif
-#define MAX(a, b) ((a)>(b)?(a):(b))
+struct animation
+{
+	int kind;
+	int fromx, fromy, tox, toy; // Warps: the view; zooms: the centre
+	double from_zf, to_zf; // Zooms only: the scales either end
+	double t; // How far through, from 0 to 1
+	Uint32 start, duration;
+};
 
-static int warp_to_midpoint(int start, int end, int i, int n) {
+static animation anim = { ANIMATION_NONE, 0, 0, 0, 0, 1.0, 1.0, 0.0, 0, 0 };
+
+static int warp_to_midpoint(int start, int end, double t) {
 	// implements chebyshev nodes for smooth scrolling
-	return (end + start) / 2. - (end - start) / 2. * cos(2 * i * M_PI / (2 * n));
-	// return (end - start) * i / n + start;
+	return (int)((end + start) / 2. - (end - start) / 2. * cos(t * M_PI));
+	// return (end - start) * t + start;
+}
+
+void start_animation(int kind, int duration)
+{
+	anim.kind = kind;
+	anim.start = SDL_GetTicks();
+	anim.duration = duration;
+	anim.t = 0.0;
 }
 
 void warp_to(int x, int y)
 {
 	// From viewx, viewy; at end we should land at x, y
-	int originx = viewx, originy = viewy;
-	const int warp_steps = MAX(abs(originy - y), abs(originx - x)) / WARP_PIXELS_PER_SECOND;
-	
-	for(int i = 0; i < warp_steps; i++)
+	if(!pointer_on)
+		show_cursor(SDL_ENABLE);
+	hide_pointer = 0;
+	if(options->warptime <= 0 || export_html)
+	{
+		viewx = x;
+		viewy = y;
+		anim.kind = ANIMATION_NONE;
+		return;
+	}
+	anim.fromx = viewx;
+	anim.fromy = viewy;
+	anim.tox = x;
+	anim.toy = y;
+	start_animation(ANIMATION_WARP, options->warptime);
+}
+
+void zoom_from(int level)
+{
+	/* Shows the change from level to the current zoom level as a zoom
+		about the centre of the view. The scale changes geometrically, so
+		the zoom looks even: */
+	if(options->zoomtime <= 0 || export_html)
+		return;
+	get_screen_centre(&anim.tox, &anim.toy);
+	anim.from_zf = zoom_factor(level);
+	anim.to_zf = zoom_factor(zoom_level);
+	start_animation(ANIMATION_ZOOM, options->zoomtime);
+}
+
+int step_animation()
+{
+	// Moves on to where the animation should be by now; 0 if there is none
+	Uint32 elapsed;
+
+	if(anim.kind == ANIMATION_NONE)
+		return 0;
+	elapsed = SDL_GetTicks() - anim.start;
+	if(elapsed >= anim.duration)
+	{
+		finish_animation();
+		return 1;
+	}
+	anim.t = (double)elapsed / (double)anim.duration;
+	if(anim.kind == ANIMATION_WARP)
+	{
+		viewx = warp_to_midpoint(anim.fromx, anim.tox, anim.t);
+		viewy = warp_to_midpoint(anim.fromy, anim.toy, anim.t);
+	}
+	return 1;
+}
+
+void animation_frame()
+{
+	// Draws the frame for step_animation()'s last step
+	double t = anim.t;
+
+	if(anim.kind != ANIMATION_ZOOM)
 	{
-		viewx = warp_to_midpoint(originx, x, i, warp_steps - 1);
-		viewy = warp_to_midpoint(originy, y, i, warp_steps - 1);
 		refresh();
-		SDL_Delay(WARP_FRAME_WAIT_MILLISECONDS);
+		return;
 	}
-	// Flush events:
-	SDL_Event event;
-	while(SDL_PollEvent(&event) != 0) ;
-	if(!pointer_on)
-		SDL_ShowCursor(SDL_ENABLE);
-	hide_pointer = 0;
+	t = t * t * (3.0 - 2.0 * t); // Eased in and out
+	cls();
+	zoom_copy_all_to_screen(render_list, anim.tox, anim.toy,
+			anim.from_zf * pow(anim.to_zf / anim.from_zf, t));
+	present();
+}
+
+int finish_animation()
+{
+	// Jumps to the end of any animation; returns 1 if there was one
+	if(anim.kind == ANIMATION_NONE)
+		return 0;
+	if(anim.kind == ANIMATION_WARP)
+	{
+		viewx = anim.tox;
+		viewy = anim.toy;
+	}
+	anim.kind = ANIMATION_NONE;
+	refreshreq = 1;
+	return 1;
+}
+
+int stop_animation()
+{
+	// Leaves the view wherever a warp has got to, or ends a zoom
+	if(anim.kind == ANIMATION_NONE)
+		return 0;
+	anim.kind = ANIMATION_NONE;
+	refreshreq = 1;
+	return 1;
 }
 
 void warp_to_slide(slide *sl)
@@ -582,38 +750,115 @@ void copy_radar_to_screen()
 	SDL_Rect dst;
 	dst.x = SCREEN_WIDTH - RADAR_WIDTH;
 	dst.y = SCREEN_HEIGHT - RADAR_HEIGHT;
-	int ret = SDL_BlitSurface(radar, NULL, screen, &dst);
+	int ret = blend_blit(radar, NULL, screen, &dst);
 	if(ret != 0)
-		error("SDL_BlitSurface returned %d\n", ret);
+		error("blend_blit returned %d\n", ret);
 }
 
-void render_radar(int cx, int cy, hotspotvector *hsv, int slide_num)
+void draw_radar_slide(SDL_Surface *surface, slide *sl, int x1, int y1)
 {
-	slide *sl;
 	SDL_Rect dst;
-	int x1, y1;
-	
-	for(int i = 0; i < render_list->count(); i++)
+
+	dst.x = x1;
+	dst.y = y1;
+	dst.w = sl->scr_w / RADAR_MAG;
+	dst.h = sl->scr_h / RADAR_MAG;
+	if(sl->image_file != NULL)
 	{
-		sl = render_list->item(i);
-		x1 = (sl->x - cx) / RADAR_MAG + RADAR_WIDTH / 2;
-		y1 = (sl->y - cy) / RADAR_MAG + RADAR_HEIGHT / 2;
+		SDL_FillRect(surface, &dst, colour->white_fill);
 		dst.x = x1;
 		dst.y = y1;
 		dst.w = sl->scr_w / RADAR_MAG;
 		dst.h = sl->scr_h / RADAR_MAG;
-		if(hsv != NULL)
+		aaellipseColor(surface, dst.x + dst.w / 2, dst.y + dst.h / 2,
+				(dst.w - 1) / 2, (dst.h - 1) / 2, colour->black_pen);
+	}
+	else
+	{
+		SDL_FillRect(surface, &dst, colour->fills->item(sl->st->barcolour));
+	}
+	dst.x = x1;
+	dst.y = y1;
+	dst.w = sl->scr_w / RADAR_MAG;
+	dst.h = sl->scr_h / RADAR_MAG;
+	rectangleColor(surface, dst.x, dst.y, dst.x + dst.w - 1,
+			dst.y + dst.h - 1, colour->black_pen);
+}
+
+/* The slides as seen on the radar are drawn once into a map of the whole
+	canvas, which the radar window is then cut from as the view moves. The
+	map is only redrawn when a slide is moved, resized or restacked: */
+static SDL_Surface *radar_map = NULL;
+static int radar_map_x, radar_map_y; // Canvas position of its top left
+static int radar_map_stale = 1;
+
+void invalidate_radar()
+{
+	radar_map_stale = 1;
+}
+
+void draw_radar_map()
+{
+	slide *sl;
+	int x1, y1, x2, y2;
+
+	if(radar_map != NULL)
+		free_surface(radar_map);
+	x1 = y1 = x2 = y2 = 0;
+	for(sl = render_list->bottom; sl != NULL; sl = sl->above)
+	{
+		if(sl == render_list->bottom || sl->x < x1) x1 = sl->x;
+		if(sl == render_list->bottom || sl->y < y1) y1 = sl->y;
+		if(sl == render_list->bottom || sl->x + sl->scr_w > x2)
+			x2 = sl->x + sl->scr_w;
+		if(sl == render_list->bottom || sl->y + sl->scr_h > y2)
+			y2 = sl->y + sl->scr_h;
+	}
+	radar_map_x = x1;
+	radar_map_y = y1;
+	radar_map = alloc_surface((x2 - x1) / RADAR_MAG + 1,
+			(y2 - y1) / RADAR_MAG + 1);
+	clear_surface(radar_map, colour->grey_fill);
+	for(sl = render_list->bottom; sl != NULL; sl = sl->above)
+	{
+		draw_radar_slide(radar_map, sl, (sl->x - x1) / RADAR_MAG,
+				(sl->y - y1) / RADAR_MAG);
+	}
+	radar_map_stale = 0;
+}
+
+void render_radar(int cx, int cy, hotspotvector *hsv, int slide_num)
+{
+	slide *sl;
+	int x1, y1;
+	
+	if(hsv == NULL)
+	{
+		SDL_Rect dst;
+
+		// Just the part of the map around (cx, cy):
+		if(radar_map_stale)
+			draw_radar_map();
+		dst.x = (radar_map_x - cx) / RADAR_MAG + RADAR_WIDTH / 2;
+		dst.y = (radar_map_y - cy) / RADAR_MAG + RADAR_HEIGHT / 2;
+		SDL_BlitSurface(radar_map, NULL, radar, &dst);
+	}
+	else
+	{
+		for(sl = render_list->bottom; sl != NULL; sl = sl->above)
 		{
 			int x2, y2;
 			hotspot *hs;
-			
-			x2 = dst.x + dst.w - 1;
-			y2 = dst.y + dst.h - 1;
-			
+		
+			x1 = (sl->x - cx) / RADAR_MAG + RADAR_WIDTH / 2;
+			y1 = (sl->y - cy) / RADAR_MAG + RADAR_HEIGHT / 2;
+			x2 = x1 + sl->scr_w / RADAR_MAG - 1;
+			y2 = y1 + sl->scr_h / RADAR_MAG - 1;
+		
 			if(!(x2 < 0 || y2 < 0 || x1 >= RADAR_WIDTH || y1 >= RADAR_HEIGHT))
 			{
 				// Some kind of overlap (now truncate if necessary):
-				
+			
 				hs = new hotspot();
 				hs->sl = sl;
 				hs->card = 0;
@@ -621,35 +866,16 @@ void render_radar(int cx, int cy, hotspotvector *hsv, int slide_num)
 
 				hs->x1 = (x1 < 0) ? 0 : x1;
 				hs->y1 = (y1 < 0) ? 0 : y1;
-				
+			
 				if(x2 >= RADAR_WIDTH) x2 = RADAR_WIDTH - 1;
 				if(y2 >= RADAR_HEIGHT) y2 = RADAR_HEIGHT - 1;				
 				hs->x2 = x2;
 				hs->y2 = y2;
-				
+			
 				hsv->add(hs);
 			}
+			draw_radar_slide(radar, sl, x1, y1);
 		}
-		if(sl->image_file != NULL)
-		{
-			SDL_FillRect(radar, &dst, colour->white_fill);
-			dst.x = x1;
-			dst.y = y1;
-			dst.w = sl->scr_w / RADAR_MAG;
-			dst.h = sl->scr_h / RADAR_MAG;
-			aaellipseColor(radar, dst.x + dst.w / 2, dst.y + dst.h / 2,
-					(dst.w - 1) / 2, (dst.h - 1) / 2, colour->black_pen);
-		}
-		else
-		{
-			SDL_FillRect(radar, &dst, colour->fills->item(sl->st->barcolour));
-		}
-		dst.x = x1;
-		dst.y = y1;
-		dst.w = sl->scr_w / RADAR_MAG;
-		dst.h = sl->scr_h / RADAR_MAG;
-		rectangleColor(radar, dst.x, dst.y, dst.x + dst.w - 1,
-				dst.y + dst.h - 1, colour->black_pen);
 	}
 	rectangleColor(radar, 0, 0, RADAR_WIDTH - 1, RADAR_HEIGHT - 1,
 			colour->black_pen);
@@ -678,7 +904,7 @@ void render_radar(int cx, int cy, hotspotvector *hsv, int slide_num)
 		}
 		else
 		{
-			sl = render_list->item(slide_num);
+			sl = talk->item(slide_num);
 			x = (sl->x + sl->scr_w / 2 - cx) / RADAR_MAG + RADAR_WIDTH / 2;
 			y = (sl->y + sl->scr_h / 2 - cy) / RADAR_MAG + RADAR_HEIGHT / 2;
 		}
@@ -698,13 +924,41 @@ void osd()
 {
 	if(memory_display)
 	{
+		static int memuse = 0;
+		static Uint32 last_check = 0;
 		char textstr[40];	
-		int memuse = check_memory();
+		Uint32 now = SDL_GetTicks();
+		
+		// Only go to /proc once a second, the rest is counted as we go:
+		if(memuse == 0 || now - last_check >= 1000)
+		{
+			memuse = check_memory();
+			last_check = now;
+		}
 		sprintf(textstr, "%d", memuse);
 		int w, h;
-		TTF_SizeUTF8(osd_font, textstr, &w, &h);
+		measure_text(osd_font, textstr, &w, &h);
 		render_text(textstr, osd_font, &colour->red_text, screen,
 				SCREEN_WIDTH - 15 - w, SCREEN_HEIGHT - 5 - h);
+		int y = SCREEN_HEIGHT - 5 - h;
+		if(options->memorybudget > 0 && options->compress)
+		{
+			char packstr[100];
+			
+			describe_compression(packstr);
+			measure_text(help_font, packstr, &w, &h);
+			y -= h;
+			render_text(packstr, help_font, &colour->red_text, screen,
+					SCREEN_WIDTH - 15 - w, y);
+		}
+		for(int c = MEM_CATEGORIES - 1; c >= 0; c--)
+		{
+			describe_memory(c, textstr);
+			measure_text(help_font, textstr, &w, &h);
+			y -= h;
+			render_text(textstr, help_font, &colour->red_text, screen,
+					SCREEN_WIDTH - 15 - w, y);
+		}
 	}
 	if(help_display)
 	{
@@ -726,7 +980,7 @@ void osd()
 		int i;
 		int bottom = 5;
 		for (i = 0; i < 12; i++) {
-			TTF_SizeUTF8(help_font, helpstr[i], &w, &h);
+			measure_text(help_font, helpstr[i], &w, &h);
 			render_text(helpstr[i], help_font, &colour->red_text, screen,
 					10 /*SCREEN_WIDTH - 15 - w*/, SCREEN_HEIGHT - bottom - h);
 			bottom += h;
@@ -765,20 +1019,21 @@ void osd()
 					SDL_Surface *title_surface, *reduced_surface;
 					double f = 0.5;
 					
+					ensure_rendered(magnify);
 					src.x = 0;
 					src.y = 0;
 					src.w = magnify->scr_w;
 					src.h = to_screen_coords(magnify->st->titlespacing - TITLE_EDGE);
 				
 					title_surface = alloc_surface(src.w, src.h);
-					SDL_BlitSurface(magnify->scaled, &src, title_surface, NULL);
+					copy_scaled(magnify, &src, title_surface, 0, 0);
 					
 					reduced_surface = zoomSurface(title_surface, f, f, 1);
-					SDL_FreeSurface(title_surface);
+					free_surface(title_surface);
 					
 					mag_surface = alloc_surface(reduced_surface->w,
 							reduced_surface->h);
-					SDL_SetAlpha(mag_surface, SDL_SRCALPHA | SDL_RLEACCEL, 0xCC);						
+					SDL_SetAlpha(mag_surface, SDL_SRCALPHA, 0xCC);						
 					SDL_BlitSurface(reduced_surface, NULL, mag_surface, NULL);
 					SDL_FreeSurface(reduced_surface);
 				}
@@ -786,21 +1041,22 @@ void osd()
 				dst.x = (SCREEN_WIDTH - mag_surface->w) / 2;
 				dst.y = margin;
 				// dst.y = SCREEN_HEIGHT - mag_surface->h - margin;
-				SDL_BlitSurface(mag_surface, NULL, screen, &dst);
+				blend_blit(mag_surface, NULL, screen, &dst);
 			}
 		}
 		else
 		{
+			ensure_mini(magnify);
 			if(mag_surface == NULL)
 			{
 				mag_surface = alloc_surface(magnify->mini->w, magnify->mini->h);
-				SDL_SetAlpha(mag_surface, SDL_SRCALPHA | SDL_RLEACCEL, 0xCC);
+				SDL_SetAlpha(mag_surface, SDL_SRCALPHA, 0xCC);
 				SDL_BlitSurface(magnify->mini, NULL, mag_surface, NULL);
 			}
 			
 			dst.x = SCREEN_WIDTH - magnify->mini->w;
 			dst.y = SCREEN_HEIGHT - magnify->mini->h;
-			SDL_BlitSurface(mag_surface, NULL, screen, &dst);
+			blend_blit(mag_surface, NULL, screen, &dst);
 		}
 	}
 	for(int i = 0; i < 4; i++)
@@ -829,7 +1085,7 @@ void osd()
 					break;
 				default: error("Impossible case"); break;
 			}
-			SDL_BlitSurface(pin[i], NULL, screen, &dst);
+			blend_blit(pin[i], NULL, screen, &dst);
 		}
 	}
 }
@@ -847,16 +1103,28 @@ void refresh(int flip)
 	if(pointer_on && !hide_pointer)
 		pointer(pointer_x, pointer_y);
 	if(flip)
-		SDL_Flip(screen);
+		present();
 	refreshreq = 0;
+	enforce_memory_budget();
 }
 
 void pop_to_front(slide *sl) // Note: Doesn't do a refresh
 {
-	int index = render_list->find(sl);
-	if(index == -1)
-		error("Can't find slide in render_list (impossible)");
-	render_list->demote(index);
+	if(sl == render_list->top)
+		return;
+	// Take it out of the stack...
+	if(sl->below != NULL)
+		sl->below->above = sl->above;
+	else
+		render_list->bottom = sl->above;
+	sl->above->below = sl->below;
+	// ...and put it back on top:
+	sl->below = render_list->top;
+	sl->above = NULL;
+	render_list->top->above = sl;
+	render_list->top = sl;
+	damage_overview(sl);
+	invalidate_radar(); // Slides overlap on the radar too
 }
 
 void redraft(slide *sl)
@@ -1070,12 +1338,6 @@ void goto_card(slide *sl, int n)
 	redraft(sl);
 }
 
-void update_feedback(slide *sl)
-{
-	reallocate_surfaces(sl);
-	scale(sl);
-}
-
 void unselect_all()
 {
 	slide *sl;
@@ -1093,20 +1355,24 @@ void single_slide_view(slide *sl)
 	SDL_Rect dst;
 	double f, g;
 
-	f = (double)SCREEN_WIDTH / (double)sl->des_w;
-	g = (double)SCREEN_HEIGHT / (double)sl->des_h;
+	ensure_rendered(sl);
+	f = (double)SCREEN_WIDTH / (double)sl->render->w;
+	g = (double)SCREEN_HEIGHT / (double)sl->render->h;
 	if(g < f)
 		f = g;
-	full_surface = zoomSurface(sl->render, f, f, 1);
+	if(sl->image_file != NULL && sl->reduced && f > 1.0)
+		full_surface = maximise_picture(sl, SCREEN_WIDTH, SCREEN_HEIGHT);
+	else
+		full_surface = zoom_surface(sl->render, f, MEM_OSD);
 	
 	dst.x = (SCREEN_WIDTH - full_surface->w) / 2;
 	dst.y = (SCREEN_HEIGHT - full_surface->h) / 2;
 	
 	cls();
 	SDL_BlitSurface(full_surface, NULL, screen, &dst);
-	SDL_Flip(screen);
+	present();
 	
-	SDL_FreeSurface(full_surface);
+	free_surface(full_surface);
 	viewloop();
 	refreshreq = 1;
 }
@@ -1143,6 +1409,11 @@ void split_screen(slide *sl1, slide *sl2)
 		if(f2 * (double)(sl2->des_h) > (double)SCREEN_HEIGHT)
 			f2 = (double)SCREEN_HEIGHT / (double)(sl2->des_h);
 	}
+	ensure_rendered(sl1);
+	ensure_rendered(sl2);
+	// The render surfaces may be at design or screen resolution:
+	f1 = f1 * (double)sl1->des_w / (double)sl1->render->w;
+	f2 = f2 * (double)sl2->des_w / (double)sl2->render->w;
 	surface1 = zoomSurface(sl1->render, f1, f1, 1);
 	surface2 = zoomSurface(sl2->render, f2, f2, 1);
 	
@@ -1169,7 +1440,7 @@ void split_screen(slide *sl1, slide *sl2)
 		dst.y = (SCREEN_HEIGHT - surface2->h) / 2;
 	}
 	SDL_BlitSurface(surface2, NULL, screen, &dst);
-	SDL_Flip(screen);
+	present();
 	
 	SDL_FreeSurface(surface1);
 	SDL_FreeSurface(surface2);
@@ -1183,7 +1454,7 @@ void viewloop()
 
 	while(1)
 	{
-		SDL_WaitEvent(&event);
+		wait_event(&event);
 		switch(event.type)
 		{
 			case SDL_KEYDOWN:
@@ -1220,11 +1491,11 @@ void do_pin()
 {
 	slide *sl = NULL;
 	SDL_Surface *reduced;
-	double f = 0.5;
+	double f = 0.5 * render_zoom(); // Half screen size
 	
 	if(pin[1] != NULL)
 	{
-		SDL_FreeSurface(pin[1]);
+		free_surface(pin[1]);
 		pin[1] = NULL;
 		refreshreq = 1;
 		return;
@@ -1237,10 +1508,11 @@ void do_pin()
 		return;
 	pinned = sl;
 	
-	reduced = zoomSurface(sl->scaled, f, f, 1);
+	ensure_rendered(sl);
+	reduced = zoomSurface(sl->render, f, f, 1);
 
 	pin[1] = alloc_surface(reduced->w, reduced->h);
-	SDL_SetAlpha(pin[1], SDL_SRCALPHA | SDL_RLEACCEL, 0xDD);
+	SDL_SetAlpha(pin[1], SDL_SRCALPHA, 0xDD);
 	SDL_BlitSurface(reduced, NULL, pin[1], NULL);
 	SDL_FreeSurface(reduced);
 	
@@ -1253,7 +1525,7 @@ void do_pin(int corner)
 
 	if(pin[corner] != NULL)
 	{
-		SDL_FreeSurface(pin[corner]);
+		free_surface(pin[corner]);
 		pin[corner] = NULL;
 	}
 	sl = slide_under_pointer();
@@ -1261,14 +1533,14 @@ void do_pin(int corner)
 	{
 		SDL_Surface *reduced;
 		
-		double f = 0.5;
-		reduced = zoomSurface(sl->scaled, f, f, 1);
+		double f = 0.5 * render_zoom(); // Half screen size
+		ensure_rendered(sl);
+		reduced = zoomSurface(sl->render, f, f, 1);
 
 		if(corner == 1)		
 			pinned = sl;
 		pin[corner] = alloc_surface(reduced->w, reduced->h);
-		SDL_SetAlpha(pin[corner],
-				SDL_SRCALPHA | SDL_RLEACCEL, 0xDD);
+		SDL_SetAlpha(pin[corner], SDL_SRCALPHA, 0xDD);
 		SDL_BlitSurface(reduced, NULL, pin[corner], NULL);
 		
 		SDL_FreeSurface(reduced);
@@ -1276,6 +1548,34 @@ void do_pin(int corner)
 	refreshreq = 1;
 }
 
+int jump_motion(SDL_MouseMotionEvent *motion)
+{
+	// Sudden jumps of the pointer are ignored when dragging to scroll
+	return abs(motion->xrel) >= 100 || abs(motion->yrel) >= 100;
+}
+
+int merge_motion(SDL_MouseMotionEvent *motion)
+{
+	/* Folds the next queued event into motion if it is more of the same
+		movement - with the same buttons held, and not a jump - so that a
+		fast mouse doesn't leave the view behind handling each one in turn.
+		Events are only taken from the front of the queue, never out of
+		order. Returns 1 if it took one: */
+	SDL_Event next;
+
+	if(SDL_PeepEvents(&next, 1, SDL_PEEKEVENT, SDL_ALLEVENTS) != 1)
+		return 0;
+	if(next.type != SDL_MOUSEMOTION || next.motion.state != motion->state ||
+			jump_motion(&next.motion))
+		return 0;
+	SDL_PeepEvents(&next, 1, SDL_GETEVENT, SDL_MOUSEMOTIONMASK);
+	motion->x = next.motion.x;
+	motion->y = next.motion.y;
+	motion->xrel += next.motion.xrel;
+	motion->yrel += next.motion.yrel;
+	return 1;
+}
+
 int mainloop()
 {
 	SDL_Event event;
@@ -1290,6 +1590,7 @@ int mainloop()
 	Uint8 button;
 	int mouse_x, mouse_y, delta_x, delta_y;
 	SDL_MouseMotionEvent *motion;
+	int jumped;
 	Uint8 but_state;
 	SDLMod modkeys;
 
@@ -1308,7 +1609,6 @@ int mainloop()
 	slide *grabbed = NULL;
 	subimage *focus = NULL;
 	displayline *lit = NULL;
-	slide *sl_lit = NULL;
 	slidevector *selected = new slidevector();
 	int selections_added = 0;
 	magnify = NULL;
@@ -1324,15 +1624,17 @@ int mainloop()
 	}
 	while(1)
 	{
-		if(SDL_PollEvent(&event) == 0)
+		if(poll_event(&event) == 0)
 		{
+			if(step_animation())
+			{
+				fix_position(&prefx, &prefy);
+				animation_frame();
+				pace_frame();
+				continue;
+			}
 			if(updatereq)
 			{
-				if(focus != NULL)
-				{
-					measure_slide(grabbed);
-					render_slide(grabbed);
-				}
 				updatereq = 0;
 				refreshreq = 1;
 			}
@@ -1348,7 +1650,7 @@ int mainloop()
 			{
 				autoscroll(&prefx, &prefy);
 				refresh();
-				SDL_Delay(5);
+				pace_frame();
 				continue;
 			}
 			if(refreshreq)
@@ -1374,8 +1676,13 @@ int mainloop()
 					}
 				}
 			}
-			SDL_WaitEvent(&event);
+			wait_event(&event);
 		}
+		// A key acts from where a warp was going, a click from where it is:
+		if(event.type == SDL_KEYDOWN && finish_animation())
+			fix_position(&prefx, &prefy);
+		else if(event.type == SDL_MOUSEBUTTONDOWN && stop_animation())
+			fix_position(&prefx, &prefy);
 		switch(event.type)
 		{
 			case SDL_KEYDOWN:
@@ -1389,19 +1696,19 @@ int mainloop()
 					if(raw == 93 && extra_button[0] == 0)
 					{
 						extra_button[0] = 1;
-						SDL_ShowCursor(SDL_DISABLE);
+						show_cursor(SDL_DISABLE);
 						hide_pointer = 1;
 					}
 					else if(raw == 123 && extra_button[1] == 0)
 					{
 						extra_button[1] = 1;
-						SDL_ShowCursor(SDL_DISABLE);
+						show_cursor(SDL_DISABLE);
 						hide_pointer = 1;
 					}
 					else if(raw == 127 && extra_button[2] == 0)
 					{
 						extra_button[2] = 1;
-						SDL_ShowCursor(SDL_DISABLE);
+						show_cursor(SDL_DISABLE);
 						hide_pointer = 1;
 						change_zoom_level(1);
 						scrollreqx = scrollreqy = 0;
@@ -1437,7 +1744,7 @@ int mainloop()
 							hover_mode = 1;
 						if(mag_surface != NULL)
 						{
-							SDL_FreeSurface(mag_surface);
+							free_surface(mag_surface);
 							mag_surface = NULL;
 						}
 						if(zoom_level == 2 && magnify != NULL)
@@ -1489,8 +1796,13 @@ int mainloop()
 						}
 						break;
 					case SDLK_m:
-						memory_display = 1 - memory_display;
-						refreshreq = 1;
+						if(mod & KMOD_SHIFT)
+							dump_memory(config->memory_path, check_memory());
+						else
+						{
+							memory_display = 1 - memory_display;
+							refreshreq = 1;
+						}
 						break;
 					case SDLK_n:
 						radar_window = 1 - radar_window;
@@ -1498,7 +1810,7 @@ int mainloop()
 						break;
 					case SDLK_p:
 						pointer_on = 1 - pointer_on;
-						SDL_ShowCursor(pointer_on ? SDL_DISABLE : SDL_ENABLE);
+						show_cursor(pointer_on ? SDL_DISABLE : SDL_ENABLE);
 						refreshreq = 1;
 						break;
 					case SDLK_q:
@@ -1545,12 +1857,12 @@ int mainloop()
 					case SDLK_TAB:
 						if(mod & KMOD_SHIFT)
 						{
-							SDL_WM_IconifyWindow();
+							iconify_window();
 							// SDL_WM_SetCaption("Multitalk", "Multitalk");
 						}
 						else
 						{
-							SDL_WM_ToggleFullScreen(screen);
+							toggle_fullscreen();
 							fullscreen = 1 - fullscreen;
 						}
 						break;
@@ -1558,12 +1870,12 @@ int mainloop()
 						{
 							SDL_GrabMode grab;
 							
-							grab = SDL_WM_GrabInput(SDL_GRAB_QUERY);
+							grab = grab_input(SDL_GRAB_QUERY);
 							if(grab == SDL_GRAB_OFF)
 								grab = SDL_GRAB_ON;
 							else
 								grab = SDL_GRAB_OFF;
-							SDL_WM_GrabInput(grab);
+							grab_input(grab);
 						}
 						break;
 					case SDLK_COMMA:
@@ -1663,7 +1975,7 @@ int mainloop()
 					{
 						extra_button[0] = 0;
 						if(!pointer_on)
-							SDL_ShowCursor(SDL_ENABLE);
+							show_cursor(SDL_ENABLE);
 						hide_pointer = 0;
 						button_release(&scrollreqx, &scrollreqy, &prefx, &prefy,
 								(mod & KMOD_ALT) ? 0 : 1);
@@ -1672,7 +1984,7 @@ int mainloop()
 					{
 						extra_button[1] = 0;
 						if(!pointer_on)
-							SDL_ShowCursor(SDL_ENABLE);
+							show_cursor(SDL_ENABLE);
 						hide_pointer = 0;
 						button_release(&scrollreqx, &scrollreqy, &prefx, &prefy,
 								(mod & KMOD_ALT) ? 0 : 1);
@@ -1681,7 +1993,7 @@ int mainloop()
 					{
 						extra_button[2] = 0;
 						if(!pointer_on)
-							SDL_ShowCursor(SDL_ENABLE);
+							show_cursor(SDL_ENABLE);
 						hide_pointer = 0;
 						change_zoom_level(0);
 						updatereq = 0;
@@ -1718,6 +2030,13 @@ int mainloop()
 				break;
 			case SDL_MOUSEMOTION:
 				motion = &event.motion;
+				/* All the movement queued up so far is handled as one, except
+					when sweeping with the control key to select slides, where
+					every position passed over counts: */
+				jumped = jump_motion(motion);
+				if(!jumped && (control_key == 0 || motion->state != 0 ||
+						extra_button[0] || extra_button[1] || extra_button[2]))
+					while(merge_motion(motion)) ;
 				mouse_x = motion->x;
 				mouse_y = motion->y;
 				delta_x = motion->xrel;
@@ -1733,9 +2052,7 @@ int mainloop()
 				drag_dist += abs(delta_x) + abs(delta_y);
 				if(drag_dist >= CLICK_THRESHOLD && lit != NULL)
 				{
-					lit->highlighted = 0;
-					render_line(sl_lit, lit, NULL, sl_lit->render);
-					update_feedback(sl_lit);
+					set_overlay(NULL, NULL);
 					lit = NULL;
 					refreshreq = 1;
 				}
@@ -1755,14 +2072,17 @@ int mainloop()
 								sl = selected->item(i);
 								sl->x += delta_x * zoom_factor(zoom_level);
 								sl->y += delta_y * zoom_factor(zoom_level);
+								damage_overview(sl);
 							}
 						}
 						else
 						{
 							grabbed->x += delta_x * zoom_factor(zoom_level);
 							grabbed->y += delta_y * zoom_factor(zoom_level);
+							damage_overview(grabbed);
 						}
 						slides_moved = 1;
+						invalidate_radar();
 						updatereq = 1;
 
 						// Scroll screen if window has moved off:
@@ -1771,13 +2091,13 @@ int mainloop()
 					}
 					else
 					{
-						// Drag sub-image:
+						// Drag sub-image (drawn over the slide until dropped):
 						focus->scr_x += delta_x * zoom_factor(zoom_level);
 						focus->scr_y += delta_y * zoom_factor(zoom_level);
 						focus->des_x = to_design_coords(focus->scr_x);
 						focus->des_y = to_design_coords(focus->scr_y);
 						slides_moved = 1;
-						updatereq = 1;
+						refreshreq = 1;
 					}
 				}
 				else if(but_state & SDL_BUTTON(1) || but_state & SDL_BUTTON(2) ||
@@ -1785,8 +2105,7 @@ int mainloop()
 						extra_button[1] || extra_button[2])
 				{
 					// Drag to scroll:
-					if(delta_x < 100 && delta_y < 100 && delta_x > -100 &&
-							delta_y > -100)
+					if(!jumped)
 					{
 						if(reverse_mouse)
 						{
@@ -1821,7 +2140,7 @@ int mainloop()
 						magnify = sl;
 						if(mag_surface != NULL)
 						{
-							SDL_FreeSurface(mag_surface);
+							free_surface(mag_surface);
 							mag_surface = NULL;
 						}
 						refreshreq = 1;
@@ -1831,25 +2150,36 @@ int mainloop()
 			case SDL_MOUSEBUTTONDOWN:
 				click = &event.button;
 				button = click->button; // SDL_BUTTON_LEFT/MIDDLE/RIGHT
+				if(button == SDL_BUTTON_WHEELUP ||
+						button == SDL_BUTTON_WHEELDOWN)
+				{
+					// Wheel zooms in or out a level:
+					if(button == SDL_BUTTON_WHEELUP && zoom_level > 0)
+						change_zoom_level(zoom_level - 1);
+					else if(button == SDL_BUTTON_WHEELDOWN && zoom_level < 2)
+						change_zoom_level(zoom_level + 1);
+					scrollreqx = scrollreqy = 0;
+					fix_position(&prefx, &prefy);
+					refreshreq = 1;
+					break;
+				}
 				mouse_x = click->x;
 				mouse_y = click->y;
 				clickx = viewx + zoom_factor(zoom_level) * mouse_x;
 				clicky = viewy + zoom_factor(zoom_level) * mouse_y;
 				modkeys = SDL_GetModState();
 				but_state = SDL_GetMouseState(NULL, NULL);
-				SDL_ShowCursor(SDL_DISABLE);
+				show_cursor(SDL_DISABLE);
 				hide_pointer = 1;
 				magnify = NULL;
 				if(mag_surface != NULL)
 				{
-					SDL_FreeSurface(mag_surface);
+					free_surface(mag_surface);
 					mag_surface = NULL;
 				}
 				if(lit != NULL)
 				{
-					lit->highlighted = 0;
-					render_line(sl_lit, lit, NULL, sl_lit->render);
-					update_feedback(sl_lit);
+					set_overlay(NULL, NULL);
 					lit = NULL;
 					refreshreq = 1;
 				}
@@ -1890,9 +2220,9 @@ int mainloop()
 					{
 						if(focus != NULL)
 						{
-							/* Save slide background for faster redraws whilst
-								dragging embedded image: */
-							;
+							/* Redraw the slide without the embedded image,
+								for faster redraws whilst dragging it: */
+							drag_image(grabbed, focus);
 						}
 						pop_to_front(grabbed);
 						refreshreq = 1;
@@ -1914,10 +2244,7 @@ int mainloop()
 						if(sl_remote != NULL) // Hyperlink under mouse
 						{
 							// Visual feedback for hyperlink click:
-							lit->highlighted = 1;
-							sl_lit = sl_local;
-							render_line(sl_local, lit, NULL, sl_local->render);
-							update_feedback(sl_local);
+							set_overlay(sl_local, lit);
 							refreshreq = 1;
 						}
 						else if(line_num == 0 && zoom_level == 1)
@@ -1933,10 +2260,7 @@ int mainloop()
 							lit = fold_possible(sl_local, line_num);
 							if(lit != NULL)
 							{
-								lit->highlighted = 1;
-								sl_lit = sl_local;
-								render_line(sl_local, lit, NULL, sl_local->render);
-								update_feedback(sl_local);
+								set_overlay(sl_local, lit);
 								refreshreq = 1;
 							}
 						}
@@ -1954,17 +2278,18 @@ int mainloop()
 			case SDL_MOUSEBUTTONUP:
 				click = &event.button;
 				button = click->button; // SDL_BUTTON_LEFT/MIDDLE/RIGHT
+				if(button == SDL_BUTTON_WHEELUP ||
+						button == SDL_BUTTON_WHEELDOWN)
+					break; // Dealt with when pressed
 				mouse_x = click->x;
 				mouse_y = click->y;
 				modkeys = SDL_GetModState();
 				if(!pointer_on)
-					SDL_ShowCursor(SDL_ENABLE);
+					show_cursor(SDL_ENABLE);
 				hide_pointer = 0;
 				if(lit != NULL)
 				{
-					lit->highlighted = 0;
-					render_line(sl_lit, lit, NULL, sl_lit->render);
-					update_feedback(sl_lit);
+					set_overlay(NULL, NULL);
 					lit = NULL;
 					refreshreq = 1;
 				}
@@ -1987,9 +2312,11 @@ int mainloop()
 							grabbed->y -= extra;
 							if(extra >= SLIDE_GRID_STEP / 2)
 								grabbed->y += SLIDE_GRID_STEP;
+							damage_overview(grabbed);
 						}
 
 						slides_moved = 1;
+						invalidate_radar();
 						updatereq = 1;
 					}
 					else
@@ -2013,7 +2340,7 @@ int mainloop()
 						}
 
 						// Finalise sub-image position:
-						render_slide(grabbed);
+						drop_image();
 						updatereq = 1;
 					}
 					grabbed = NULL;
@@ -2107,7 +2434,7 @@ void splash_screen()
 	dst.h = SCREEN_HEIGHT;
 	SDL_FillRect(screen, &dst, colour->grey_fill);	
 	
-	SDL_Flip(screen);
+	present();
 }
 
 void clear_radar()
@@ -2197,9 +2524,9 @@ slide *slide_under_mouse(int mousex, int mousey, int *line_num,
 
 	if(image != NULL)
 		*image = NULL;	
-	for(int i = 0; i < talk->count(); i++)
+	// Front to back, so that the slide on top is the one found:
+	for(sl = render_list->top; sl != NULL; sl = sl->below)
 	{
-		sl = talk->item(i);
 		st = sl->st;
 		rx = x - sl->x;
 		ry = y - sl->y;
@@ -2268,60 +2595,83 @@ slide *central_slide()
 	return NULL;
 }
 
-void load_image(slide *sl)
+SDL_Surface *frame_picture(SDL_Surface *image, style *st, int category,
+		slide *owner)
 {
-	SDL_Surface *image;
-	int w, h;
+	// Surrounds a picture with the style's margin and border
+	SDL_Surface *surface;
 	SDL_Rect dst;
-	style *st = sl->st;
+	int w = image->w, h = image->h;
 	
-	image = load_png(sl->image_file, 0);
-	w = image->w;
-	h = image->h;
-	sl->render = alloc_surface(w + 2 * st->picturemargin,
-			h + 2 * st->picturemargin);
+	surface = alloc_surface(w + 2 * st->picturemargin,
+			h + 2 * st->picturemargin, category, owner);
 	dst.x = 0;
 	dst.y = 0;
-	dst.w = sl->render->w;
-	dst.h = sl->render->h;
-	SDL_FillRect(sl->render, &dst, colour->white_fill);
+	dst.w = surface->w;
+	dst.h = surface->h;
+	SDL_FillRect(surface, &dst, colour->white_fill);
 	
 	dst.x = st->picturemargin;
 	dst.y = st->picturemargin;
 	dst.w = w;
 	dst.h = h;
-	SDL_BlitSurface(image, NULL, sl->render, &dst);
-	
-	SDL_FreeSurface(image);
+	SDL_BlitSurface(image, NULL, surface, &dst);
 	
 	for(int i = 0; i < st->pictureborder; i++)
 	{
-		rectangleColor(sl->render, i, i, w + 2 * st->picturemargin - 1 - i,
+		rectangleColor(surface, i, i, w + 2 * st->picturemargin - 1 - i,
 				h + 2 * st->picturemargin - 1 - i,
 				colour->pens->item(st->bordercolour));
 	}
+	return surface;
+}
+
+SDL_Surface *maximise_picture(slide *sl, int max_w, int max_h)
+{
+	/* For a picture slide which was reduced on loading, goes back to the
+		original file to fill max_w x max_h with as much detail as possible.
+		The picture comes back anything up to FAR_BEYOND times too big, or
+		if the file has less detail than that, too small; either way it is
+		then fitted exactly: */
+	SDL_Surface *image, *fitted, *surface;
+	style *st = sl->st;
+	int reduced;
 	
-	if(scalep == 1)
-		sl->scaled = sl->render;
-	else
+	max_w -= 2 * st->picturemargin;
+	max_h -= 2 * st->picturemargin;
+	image = load_picture(sl->image_file, max_w, max_h, &reduced);
+	if(image->w > max_w || image->h > max_h ||
+			(image->w < max_w && image->h < max_h))
 	{
-		if(sl->scaled != NULL)
-			error("Paranoia: scaled surface not freed up");
-		double g = (double)scalep / (double)scaleq;
-		sl->scaled = zoomSurface(sl->render, g, g, 1);
-		if(sl->scaled == NULL)
-			error("zoomSurface returned NULL");
+		fitted = fit_surface(image, max_w, max_h);
+		SDL_FreeSurface(image);
+		image = fitted;
 	}
+	surface = frame_picture(image, st, MEM_OSD, NULL);
+	SDL_FreeSurface(image);
+	return surface;
+}
 
-	double f = 1.0 / 3.0;	
-	// sl->mini = SDL_ResizeFactor(sl->scaled, (float)f, 1);
-	sl->mini = zoomSurface(sl->scaled, f, f, 1);
-	if(sl->mini == NULL)
-		error("zoomSurface returned NULL");
+void load_image(slide *sl)
+{
+	SDL_Surface *image;
+	style *st = sl->st;
+	int max_w = design_width, max_h = design_height;
 	
-	sl->micro = zoomSurface(sl->mini, f, f, 1);
-	if(sl->micro == NULL)
-		error("zoomSurface returned NULL");
+	discard_packed(sl);
+	if(design_width == -1)
+	{
+		// The talk doesn't give a design size, so it is the screen size:
+		max_w = SCREEN_WIDTH;
+		max_h = SCREEN_HEIGHT;
+	}
+	// Pictures far beyond the design size are reduced as they are decoded:
+	image = load_picture(sl->image_file,
+			to_render_coords(max_w) - 2 * st->picturemargin,
+			to_render_coords(max_h) - 2 * st->picturemargin, &sl->reduced);
+	sl->render = frame_picture(image, st, MEM_SLIDES, sl);
+	SDL_FreeSurface(image);
+	scale(sl);
 }
 
 void load_images()
@@ -2342,6 +2692,7 @@ void render_all()
 	{
 		sl = talk->item(i);
 		render_slide(sl);
+		enforce_memory_budget();
 	}
 }
 
@@ -2355,13 +2706,13 @@ void free_talk(slidevector *talk)
 		
 		// Free rendered surfaces:
 		if(sl->render != NULL)
-			SDL_FreeSurface(sl->render);
-		if(scalep != 1 && sl->scaled != NULL)
-			SDL_FreeSurface(sl->scaled);
+			free_surface(sl->render);
+		free_tiles(sl);
 		if(sl->mini != NULL)
-			SDL_FreeSurface(sl->mini);
-		if(sl->micro != NULL)
-			SDL_FreeSurface(sl->micro);
+			free_surface(sl->mini);
+		free_micro(sl);
+		free_decorations(sl);
+		discard_packed(sl);
 		
 		// Free linearised representation:
 		if(sl->repr != NULL)
@@ -2379,10 +2730,18 @@ void free_talk(slidevector *talk)
 		// Free content:
 		free_node(sl->content);
 		
-		// Free images:
+		// Free images (visible_images is a subset of embedded_images):
+		for(int i = 0; i < sl->embedded_images->count(); i++)
+		{
+			subimage *img = sl->embedded_images->item(i);
+			release_png(img->surface);
+			delete[] img->path_name;
+			if(img->hyperlink != NULL)
+				delete[] img->hyperlink;
+			delete img;
+		}
 		delete sl->embedded_images;
 		delete sl->visible_images;
-		// TODO: Should delete the actual subimage surfaces - XXX
 		if(sl->image_file != NULL)
 			delete[] sl->image_file;
 		
@@ -2406,28 +2765,35 @@ void set_view_coords(slidevector *talk)
 	viewy = sl->y + sl->scr_h / 2 - SCREEN_HEIGHT / 2;
 }
 
-slidevector *create_render_list(slidevector *talk)
+slide_stack *create_render_list(slidevector *talk)
 {
-	slidevector *render_list;
+	slide_stack *render_list;
 	slide *sl;
 	
-	render_list = new slidevector();
+	render_list = new slide_stack;
+	render_list->bottom = render_list->top = NULL;
 	for(int i = 0; i < talk->count(); i++)
 	{
 		sl = talk->item(i);
-		render_list->add(sl);
+		sl->below = render_list->top;
+		sl->above = NULL;
+		if(render_list->top != NULL)
+			render_list->top->above = sl;
+		else
+			render_list->bottom = sl;
+		render_list->top = sl;
 	}
 	return render_list;
 }
 
-void free_render_list(slidevector *render_list)
+void free_render_list(slide_stack *render_list)
 {
 	delete render_list;
 }
 
 int main(int argc, char **argv)
 {
-	int quit;
+	int quit, reloads = 0;
 	const char *talk_ref;
 	linefile *talk_lf;
 	
@@ -2438,6 +2804,8 @@ int main(int argc, char **argv)
 	peek_designsize(talk_lf);
 	set_resolution();
 	init_gui(config->caption, export_html);
+	if(!export_html && options->presentthread)
+		start_presenter();
 	if(!export_html)
 		splash_screen();
 	proc_stat_buf = new char[PROC_STAT_BUF_LEN];
@@ -2455,15 +2823,29 @@ int main(int argc, char **argv)
 		load_slide_positions(config, talk);
 		measure_all();
 		render_list = create_render_list(talk);
+		set_view_coords(talk); // Needed first so the memory budget can be applied
+		purge_sprites(); // Styles and their colours may have changed
+		set_overlay(NULL, NULL);
+		drag_image(NULL, NULL);
+		purge_overview(); // The canvas colour may have changed
 		render_all();
-		set_view_coords(talk);
+		purge_images(); // Anything no longer used since the last reload
 		if(export_html)
 		{
 			gen_html(talk);
 			break;
 		}
-		refresh();
-		quit = mainloop();
+		if(reload_test > 0)
+		{
+			// Soak test: reload straight away, reporting memory each time
+			report_memory(reloads, check_memory());
+			quit = (reloads++ == reload_test);
+		}
+		else
+		{
+			refresh();
+			quit = mainloop();
+		}
 		if(slides_moved)
 		{
 			save_slide_positions(config, talk);
@@ -2478,6 +2860,7 @@ int main(int argc, char **argv)
 		
 		free_render_list(render_list);
 		free_talk(talk);
+		free_styles(style_list);
 	}
 	return 0;
 }
@@ -29,14 +29,19 @@ void set_integer_property(dictionary *d, const char *name, int *dest);
 void set_string_property(dictionary *d, const char *name, constCharPtr *dest);
 
 // From multitalk.cpp
-SDL_Surface *alloc_surface(int w, int h);
 int to_screen_coords(int x);
 int to_design_coords(int x);
+int direct_rendering();
+int to_render_coords(int x);
+double render_zoom();
+int zoom_factor(int level);
+void load_image(slide *sl);
 
 // From multitalk.cpp for web.cpp
 extern SDL_Surface *radar;
 extern int RADAR_WIDTH, RADAR_HEIGHT, RADAR_MAG;
 void clear_radar();
+void invalidate_radar();
 void render_radar(int cx, int cy, hotspotvector *hsv = NULL,
 		int slide_num = -1);
 void goto_card(slide *sl, int n);
@@ -49,15 +54,47 @@ Options *init_options(Config *config);
 
 // From render.cpp
 void render_slide(slide *sl);
+void render_full(slide *sl);
+int tiled_slide(slide *sl);
+int zoomed_directly(slide *sl);
 void measure_slide(slide *sl);
-void render_line(slide *sl, displayline *out, DrawMode *dm,
-		SDL_Surface *surface);
-void copy_all_to_screen(slidevector *render_list, int viewx, int viewy);
-void mini_copy_all_to_screen(slidevector *render_list, int viewx, int viewy);
-void micro_copy_all_to_screen(slidevector *render_list, int viewx, int viewy);
+void copy_all_to_screen(slide_stack *render_list, int viewx, int viewy);
+void mini_copy_all_to_screen(slide_stack *render_list, int viewx, int viewy);
+void micro_copy_all_to_screen(slide_stack *render_list, int viewx, int viewy);
+void zoom_copy_all_to_screen(slide_stack *render_list, int cx, int cy,
+		double z);
 void pointer(int x, int y);
 void reallocate_surfaces(slide *sl);
 void scale(slide *sl);
+void free_decorations(slide *sl);
+void free_tiles(slide *sl);
+void copy_scaled(slide *sl, SDL_Rect *src, SDL_Surface *target, int x, int y);
+int to_draw_coords(int x);
+void set_overlay(slide *sl, displayline *out);
+void redraw_region(slide *sl, SDL_Rect *area);
+void drag_image(slide *sl, subimage *img);
+void drop_image();
+void damage_overview(slide *sl);
+void purge_overview();
+
+// From memory.cpp
+void account_bytes(int category, slide *owner, long bytes);
+void free_decoration_set(decorations *d);
+long memory_used(int category);
+long talk_bytes();
+void ensure_rendered(slide *sl);
+void ensure_mini(slide *sl);
+int slide_in_view(slide *sl);
+void enforce_memory_budget();
+void discard_packed(slide *sl);
+void describe_compression(char *s);
+void describe_memory(int category, char *s);
+void report_memory(int reloads, int vm_size);
+void dump_memory(const char *path, int vm_size);
+
+// From atlas.cpp
+SDL_Surface *pack_micro(SDL_Surface *micro, slide *owner);
+void free_micro(slide *sl);
 
 // From latex.cpp
 SDL_Surface *gen_latex(svector *tex, style *st);
@@ -151,7 +151,9 @@ slidevector *parse_talk(linefile *talk_lf, stylevector *style_list)
 				}
 				sl = new slide;
 				sl->repr = NULL; // Linear version not generated yet
-				sl->render = sl->scaled = sl->mini = sl->micro = NULL;
+				sl->render = sl->mini = sl->micro = NULL;
+				sl->micro_cell = NULL;
+				sl->tiles = NULL;
 				sl->decor.top = sl->decor.bottom = NULL;
 				sl->decor.left = sl->decor.right = NULL;
 				sl->mini_decor.top = sl->mini_decor.bottom = NULL;
@@ -162,6 +164,12 @@ slidevector *parse_talk(linefile *talk_lf, stylevector *style_list)
 				sl->deck_size = 1;
 				sl->card = 1;
 				sl->selected = 0;
+				sl->packed = NULL;
+				sl->reduced = 0;
+				sl->overview.x = sl->overview.y = 0;
+				sl->overview.w = sl->overview.h = 0; // Not on it yet
+				for(int c = 0; c < MEM_CATEGORIES; c++)
+					sl->memory[c] = 0;
 				
 				sl->image_file = NULL; // Text slide so far
 				context = new node;
@@ -503,6 +511,8 @@ displayline::displayline()
 	link = NULL;
 	link_card = 0;
 	import = NULL;
+	for(int i = 0; i < ZOOM_LEVELS; i++)
+		scaled_import[i] = NULL;
 	line = NULL;
 	
 	// Uninitialised: initial_dm, width, height, y, line_num, exposed, type
@@ -516,7 +526,12 @@ displayline::~displayline()
 		line = NULL; // Paranoia
 	}
 	if(import != NULL)
-		SDL_FreeSurface(import);
+		free_surface(import);
+	for(int i = 0; i < ZOOM_LEVELS; i++)
+	{
+		if(scaled_import[i] != NULL)
+			free_surface(scaled_import[i]);
+	}
 }
 
 void fold_all(slide *sl)
@@ -811,6 +826,13 @@ void flatten(slide *sl, slidevector *talk) // Regenerate repr
 	sl->visible_images->clear();
 	flatten(sl->content, sl->repr, sl->visible_images, talk, 0, sl->st,
 			sl->card);
+	
+	// Charge any Latex images to this slide:
+	for(int i = 0; i < sl->repr->count(); i++)
+	{
+		if(sl->repr->item(i)->import != NULL)
+			track_surface(sl->repr->item(i)->import, MEM_LATEX, sl);
+	}
 }
 
 void flatten_all(slidevector *talk)
@@ -0,0 +1,200 @@
+/* present.cpp - DMI - 19-10-2026
+
+Copyright (C) 2006-8 David Ingram
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License (version 2) as
+published by the Free Software Foundation. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_image.h>
+#include <SDL/SDL_ttf.h>
+#include <SDL/SDL_gfxPrimitives.h>
+#include <SDL/SDL_rotozoom.h>
+
+#include "datatype.h"
+#include "multitalk.h"
+
+/* With the presentthread option, frames are put on the display by a thread
+	of their own, so the main loop never waits for SDL_Flip(). Everything is
+	still drawn onto "screen", which is then one of three off-screen frames
+	rather than the display itself. present() hands the finished frame over
+	and carries on drawing the next one into another; the presenting thread
+	always shows the newest frame handed over, and any older one not yet
+	shown is simply drawn over. The three frames are passed around by index
+	under a mutex held only for the swap; a second one is held whenever the
+	display itself is used. Xlib isn't safe to use from two threads at once,
+	so the main thread has to take that lock too, for everything which
+	talks to the X server: handling events, showing and hiding the pointer,
+	and the window manager calls. That is what the wrappers below are for;
+	with no presenting thread they just call SDL. */
+
+static SDL_Surface *display = NULL; // The video surface, when screen isn't
+static SDL_Surface *frame[3];
+static int back = 0, ready = 1, shown = 2; // Always some order of 0, 1, 2
+static int fresh = 0; // The ready frame hasn't been shown yet
+static int stopping = 0;
+
+static SDL_Thread *presenter = NULL;
+static SDL_mutex *handoff = NULL, *display_lock = NULL;
+static SDL_cond *frame_ready = NULL;
+
+int present_frames(void *unused)
+{
+	int i;
+
+	(void)unused;
+	SDL_LockMutex(handoff);
+	while(1)
+	{
+		while(!fresh && !stopping)
+			SDL_CondWait(frame_ready, handoff);
+		if(stopping)
+			break;
+		i = ready;
+		ready = shown;
+		shown = i;
+		fresh = 0;
+		SDL_UnlockMutex(handoff);
+
+		SDL_LockMutex(display_lock);
+		SDL_BlitSurface(frame[shown], NULL, display, NULL);
+		SDL_Flip(display);
+		SDL_UnlockMutex(display_lock);
+
+		SDL_LockMutex(handoff);
+	}
+	SDL_UnlockMutex(handoff);
+	return 0;
+}
+
+void stop_presenter()
+{
+	// Called at exit, before SDL_Quit()
+	if(presenter == NULL)
+		return;
+	SDL_LockMutex(handoff);
+	stopping = 1;
+	SDL_CondSignal(frame_ready);
+	SDL_UnlockMutex(handoff);
+	SDL_WaitThread(presenter, NULL);
+	presenter = NULL;
+	screen = display;
+}
+
+void start_presenter()
+{
+	SDL_PixelFormat *fmt = screen->format;
+
+	if(presenter != NULL)
+		return;
+	for(int i = 0; i < 3; i++)
+	{
+		frame[i] = SDL_CreateRGBSurface(SDL_SWSURFACE, screen->w, screen->h,
+				fmt->BitsPerPixel, fmt->Rmask, fmt->Gmask, fmt->Bmask, 0);
+		if(frame[i] == NULL)
+			error("SDL_CreateRGBSurface failed on frame (%d, %d)\n",
+					screen->w, screen->h);
+		track_surface(frame[i], MEM_OSD);
+		SDL_BlitSurface(screen, NULL, frame[i], NULL);
+	}
+	handoff = SDL_CreateMutex();
+	display_lock = SDL_CreateMutex();
+	frame_ready = SDL_CreateCond();
+	if(handoff == NULL || display_lock == NULL || frame_ready == NULL)
+		error("Can't create the presentation thread's locks: %s\n",
+				SDL_GetError());
+	display = screen;
+	screen = frame[back];
+	presenter = SDL_CreateThread(present_frames, NULL);
+	if(presenter == NULL)
+		error("Can't start the presentation thread: %s\n", SDL_GetError());
+	atexit(stop_presenter); // Runs before the SDL_Quit() registered earlier
+}
+
+void present()
+{
+	// Shows what has been drawn on the screen, in place of SDL_Flip()
+	int i;
+
+	if(presenter == NULL)
+	{
+		SDL_Flip(screen);
+		return;
+	}
+	SDL_LockMutex(handoff);
+	i = back;
+	back = ready;
+	ready = i;
+	fresh = 1;
+	SDL_CondSignal(frame_ready);
+	SDL_UnlockMutex(handoff);
+	screen = frame[back];
+}
+
+void lock_display()
+{
+	if(presenter != NULL)
+		SDL_LockMutex(display_lock);
+}
+
+void unlock_display()
+{
+	if(presenter != NULL)
+		SDL_UnlockMutex(display_lock);
+}
+
+void toggle_fullscreen()
+{
+	lock_display();
+	SDL_WM_ToggleFullScreen(presenter == NULL ? screen : display);
+	unlock_display();
+}
+
+int poll_event(SDL_Event *event)
+{
+	// SDL_PollEvent(), gathering events from X under the display lock
+	lock_display();
+	SDL_PumpEvents();
+	unlock_display();
+	return SDL_PeepEvents(event, 1, SDL_GETEVENT, SDL_ALLEVENTS) > 0;
+}
+
+void wait_event(SDL_Event *event)
+{
+	/* SDL_WaitEvent(), which polls in just the same way, but mustn't hold
+		the display lock while it waits: */
+	while(!poll_event(event))
+		SDL_Delay(10);
+}
+
+int show_cursor(int toggle)
+{
+	int shown;
+
+	lock_display();
+	shown = SDL_ShowCursor(toggle);
+	unlock_display();
+	return shown;
+}
+
+void iconify_window()
+{
+	lock_display();
+	SDL_WM_IconifyWindow();
+	unlock_display();
+}
+
+SDL_GrabMode grab_input(SDL_GrabMode mode)
+{
+	SDL_GrabMode grab;
+
+	lock_display();
+	grab = SDL_WM_GrabInput(mode);
+	unlock_display();
+	return grab;
+}
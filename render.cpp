@@ -30,17 +30,100 @@ published by the Free Software Foundation. */
 
 const int TITLE_EDGE = 8;
 
+extern Options *options;
+extern int zoom_level;
+
 // Prototypes:
 void draw_subimage(SDL_Surface *target, subimage *img);
 void load_subimage(subimage *img);
 svector *split_string(const char *line, svector **codes);
 void render_decorations(slide *sl);
+void compose_decorations(slide *sl, decorations *d, int level, int w, int h);
+void draw_slide(slide *sl, SDL_Surface *surface);
+int clip_to_surface(SDL_Rect *r, int x1, int y1, int x2, int y2,
+		SDL_Surface *surface);
+
+/* Slides are laid out in design co-ordinates, and drawn at the scale of
+	whichever surface is being drawn on: the render surface, at design size
+	(level -1) or screen resolution (level 0), or the mini and micro levels
+	(1 and 2) when they are drawn directly rather than reduced. A surface
+	may also hold just part of the slide, such as one tile of it, with its
+	top left at the draw origin (in pixels at the draw level); positions
+	are converted with draw_x() and draw_y(), and sizes with
+	to_draw_coords(). */
+static int draw_level = -1;
+static int draw_p = 1, draw_q = 1;
+static int draw_x0 = 0, draw_y0 = 0;
+
+// An embedded image being dragged, left off its slide's bitmaps meanwhile:
+static slide *dragged_slide = NULL;
+static subimage *dragged = NULL;
+
+void set_draw_level(int level)
+{
+	draw_level = level;
+	if(level < 0)
+	{
+		draw_p = draw_q = 1;
+		return;
+	}
+	draw_p = scalep;
+	draw_q = scaleq * zoom_factor(level);
+}
+
+int render_level()
+{
+	// The draw level of a slide's render surface
+	return direct_rendering() ? 0 : -1;
+}
+
+int to_draw_coords(int x)
+{
+	if(draw_p == draw_q)
+		return x;
+	return (x * draw_p) / draw_q;
+}
+
+void set_draw_origin(int x, int y)
+{
+	// Put back to (0, 0) as soon as the part of the slide has been drawn
+	draw_x0 = x;
+	draw_y0 = y;
+}
+
+int draw_x(int x)
+{
+	// A position across the slide, to one on the surface being drawn on
+	return to_draw_coords(x) - draw_x0;
+}
+
+int draw_y(int y)
+{
+	return to_draw_coords(y) - draw_y0;
+}
+
+int draw_thickness(int n)
+{
+	// Borders are in screen pixels, but thinner when zoomed out
+	if(draw_level < 1 || n == 0)
+		return n;
+	n /= zoom_factor(draw_level);
+	return n > 0 ? n : 1;
+}
+
+SDL_Surface *render_icon(SDL_Surface *icon)
+{
+	// Style pictures are kept at design size, so match them to the slide:
+	if(draw_level >= 0)
+		return screen_png(icon, draw_level);
+	return icon;
+}
 
 void foldicon(int folded, int exposure_level, int x,
 		int top, int height, int y,
 		SDL_Surface *surface, style *st, int highlighted)
 {
-	// x is a left edge, y is a centre
+	// x is a left edge, y is a centre (all in design co-ordinates)
 	SDL_Surface *icon;
 	int colour_index;
 	
@@ -66,24 +149,24 @@ void foldicon(int folded, int exposure_level, int x,
 			pen = colour->pens->item(st->foldexposed3colour);
 		/* boxColor(surface, x + 7, y, x + 13,
 				y + (st->text_ascent - st->text_descent), pen); */
-		boxColor(surface, x + 7, y, x + 13, top + height - 1, pen);
+		boxColor(surface, draw_x(x + 7), draw_y(y),
+				draw_x(x + 13), draw_y(top + height) - 1, pen);
 	}
 	if(icon == NULL)
 	{
-		boxColor(surface, x, y - 10, x + 20, y + 10,
-				colour->pens->item(colour_index));
-		rectangleColor(surface, x, y - 10, x + 20, y + 10, colour->black_pen);
-		filledTrigonColor(surface, x + 3, y - 6, x + 17, y - 6,
-				x + 10, y + 6, colour->white_pen);
-		aatrigonColor(surface, x + 3, y - 6, x + 17, y - 6,
-				x + 10, y + 6, colour->black_pen);
+		SDL_Rect dst;
+		dst.x = draw_x(x);
+		dst.y = draw_y(y - 10);
+		blend_blit(fold_sprite(draw_level, colour->pens->item(colour_index)),
+				NULL, surface, &dst);
 	}
 	else
 	{
 		SDL_Rect dst;
-		dst.x = x + 10 - (icon->w / 2);
-		dst.y = y - (icon->h / 2);
-		SDL_BlitSurface(icon, NULL, surface, &dst);
+		icon = render_icon(icon);
+		dst.x = draw_x(x + 10) - (icon->w / 2);
+		dst.y = draw_y(y) - (icon->h / 2);
+		blend_blit(icon, NULL, surface, &dst);
 	}
 }
 
@@ -98,59 +181,76 @@ void exposeicon(int level, int x, int y, int height,
 		pen = colour->pens->item(st->foldexposed2colour);
 	else
 		pen = colour->pens->item(st->foldexposed3colour);
-	boxColor(surface, x + 7, y, x + 13, y + height - 1, pen);
+	boxColor(surface, draw_x(x + 7), draw_y(y),
+			draw_x(x + 13), draw_y(y + height) - 1, pen);
 }
 
 void bigbullet(int x, int y, SDL_Surface *surface, style *st)
 {
+	x = draw_x(x);
+	y = draw_y(y);
 	if(st->bullet1 != NULL)
 	{
 		SDL_Rect dst;
-		dst.x = x - (st->bullet1->w / 2);
-		dst.y = y - (st->bullet1->h / 2);
-		SDL_BlitSurface(st->bullet1, NULL, surface, &dst);
+		SDL_Surface *icon = render_icon(st->bullet1);
+		dst.x = x - (icon->w / 2);
+		dst.y = y - (icon->h / 2);
+		blend_blit(icon, NULL, surface, &dst);
 	}
 	else
 	{
-		Uint32 pen = colour->pens->item(st->bullet1colour);
-		filledCircleColor(surface, x, y, st->bullet1size, colour->light_grey_pen);
-		filledCircleColor(surface, x, y, st->bullet1size - 1, pen);
+		SDL_Rect dst;
+		int size = to_draw_coords(st->bullet1size);
+		dst.x = x - size;
+		dst.y = y - size;
+		blend_blit(bullet_sprite(size, size, 0,
+				colour->pens->item(st->bullet1colour)), NULL, surface, &dst);
 	}
 }
 
 void mediumbullet(int x, int y, SDL_Surface *surface, style *st)
 {
+	x = draw_x(x);
+	y = draw_y(y);
 	if(st->bullet2 != NULL)
 	{
 		SDL_Rect dst;
-		dst.x = x - (st->bullet2->w / 2);
-		dst.y = y - (st->bullet2->h / 2);
-		SDL_BlitSurface(st->bullet2, NULL, surface, &dst);
+		SDL_Surface *icon = render_icon(st->bullet2);
+		dst.x = x - (icon->w / 2);
+		dst.y = y - (icon->h / 2);
+		blend_blit(icon, NULL, surface, &dst);
 	}
 	else
 	{
-		Uint32 pen = colour->pens->item(st->bullet2colour);
-		filledCircleColor(surface, x, y, st->bullet2size, colour->light_grey_pen);
-		filledCircleColor(surface, x, y, st->bullet2size - 1, pen);
+		SDL_Rect dst;
+		int size = to_draw_coords(st->bullet2size);
+		dst.x = x - size;
+		dst.y = y - size;
+		blend_blit(bullet_sprite(size, size, 0,
+				colour->pens->item(st->bullet2colour)), NULL, surface, &dst);
 	}
 }
 
 void smallbullet(int x, int y, SDL_Surface *surface, style *st)
 {	
+	x = draw_x(x);
+	y = draw_y(y);
 	if(st->bullet3 != NULL)
 	{
 		SDL_Rect dst;
-		dst.x = x - (st->bullet3->w / 2);
-		dst.y = y - (st->bullet3->h / 2);
-		SDL_BlitSurface(st->bullet3, NULL, surface, &dst);
+		SDL_Surface *icon = render_icon(st->bullet3);
+		dst.x = x - (icon->w / 2);
+		dst.y = y - (icon->h / 2);
+		blend_blit(icon, NULL, surface, &dst);
 	}
 	else
 	{
-		Uint32 pen = colour->pens->item(st->bullet3colour);
-		filledEllipseColor(surface, x, y, st->bullet3size,
-				(st->bullet3size * 2) / 3, colour->light_grey_pen);
-		filledEllipseColor(surface, x, y, st->bullet3size - 1,
-				(st->bullet3size * 2) / 3 - 1, pen);
+		SDL_Rect dst;
+		int size = to_draw_coords(st->bullet3size);
+		dst.x = x - size;
+		dst.y = y - (size * 2) / 3;
+		blend_blit(bullet_sprite(size, (size * 2) / 3, 1,
+				colour->pens->item(st->bullet3colour)), NULL, surface, &dst);
 	}
 }
 
@@ -301,7 +401,7 @@ int calc_width(slide *sl)
 	if(st->enablebar)
 	{
 		char *title = sl->content->line;
-		TTF_SizeUTF8(st->title_font, title, &w, &h);
+		measure_text(st->title_font, title, &w, &h);
 	}
 	max_width = w;
 	
@@ -337,7 +437,7 @@ int calc_width(slide *sl)
 			error("Impossible out->line in render.cpp");
 		else if(out->heading && strlen(out->line) > 0)
 		{
-			TTF_SizeUTF8(st->title_font, out->line, &w, &h);
+			measure_text(st->title_font, out->line, &w, &h);
 			w += shift;
 			out->width = w;
 			if(w > max_width)
@@ -366,7 +466,7 @@ int calc_width(slide *sl)
 						font = st->fixed_font;
 					else
 						font = st->text_font;
-					TTF_SizeUTF8(font, s, &wpart, &h);
+					measure_text(font, s, &wpart, &h);
 					w += wpart;
 				}
 				if(code == '$')
@@ -377,7 +477,7 @@ int calc_width(slide *sl)
 						boldmode = 1 - boldmode;
 					else
 					{
-						TTF_SizeUTF8(st->fixed_font, "*", &wpart, &h);
+						measure_text(st->fixed_font, "*", &wpart, &h);
 						w += wpart;
 					}
 				}
@@ -387,7 +487,7 @@ int calc_width(slide *sl)
 						italicmode = 1 - italicmode;
 					else
 					{
-						TTF_SizeUTF8(st->fixed_font, "/", &wpart, &h);
+						measure_text(st->fixed_font, "/", &wpart, &h);
 						w += wpart;
 					}
 				}
@@ -421,8 +521,24 @@ void measure_slide(slide *sl)
 {
 	if(sl->image_file != NULL)
 	{
-		sl->des_w = sl->render->w;
-		sl->des_h = sl->render->h;
+		// Keep the old dimensions if the picture has been evicted:
+		if(direct_rendering())
+		{
+			// Loaded to fit the screen, so already at screen resolution:
+			if(sl->render != NULL)
+			{
+				sl->scr_w = sl->render->w;
+				sl->scr_h = sl->render->h;
+				sl->des_w = to_design_coords(sl->scr_w);
+				sl->des_h = to_design_coords(sl->scr_h);
+			}
+			return;
+		}
+		if(sl->render != NULL)
+		{
+			sl->des_w = sl->render->w;
+			sl->des_h = sl->render->h;
+		}
 	}
 	else
 	{
@@ -431,91 +547,132 @@ void measure_slide(slide *sl)
 	}
 	sl->scr_w = to_screen_coords(sl->des_w);
 	sl->scr_h = to_screen_coords(sl->des_h);
+	invalidate_radar(); // Its size on the radar may have changed
 }
 
-void render_background(slide *sl, SDL_Surface *surface)
+void greek_text(const char *s, TTF_Font *font, Uint32 pen,
+		SDL_Surface *surface, int x, int y)
 {
-	SDL_Rect dst;
-	style *st = sl->st;
-	
-	// Set slide area to the background colour:
-	dst.x = 0;
-	dst.y = 0;
-	dst.w = sl->des_w;
-	dst.h = sl->des_h;
-	SDL_FillRect(surface, &dst, colour->fills->item(st->bgcolour));
+	// Text too small to read is drawn as a bar for each word
+	char *word = new char[strlen(s) + 1];
+	int w, h, space, n, top, bottom;
 
-	// Fill in the	titlebar area:
-	if(st->enablebar)
+	measure_text(font, " ", &space, &h);
+	top = draw_y(y + TTF_FontAscent(font) / 2);
+	bottom = draw_y(y + TTF_FontAscent(font));
+	while(*s != '\0')
 	{
-		dst.h = st->titlespacing - TITLE_EDGE;
-		SDL_FillRect(surface, &dst, colour->fills->item(st->barcolour));
+		if(*s == ' ')
+		{
+			x += space;
+			s++;
+			continue;
+		}
+		n = strcspn(s, " ");
+		strncpy(word, s, n);
+		word[n] = '\0';
+		measure_text(font, word, &w, &h);
+		boxColor(surface, draw_x(x), top, draw_x(x + w) - 1, bottom, pen);
+		x += w;
+		s += n;
+	}
+	delete[] word;
+}
+
+int slide_text(const char *s, TTF_Font *font, int colour_index,
+		SDL_Surface *surface, int x, int y, int underlined)
+{
+	/* Like render_text(), but x, y and the returned end of the text are
+		in design co-ordinates, whatever the resolution of the surface: */
+	TTF_Font *scaled;
+	int w, h;
+
+	if(draw_level < 0)
+	{
+		return render_text(s, font, colour_index, surface, draw_x(x),
+				draw_y(y), underlined) + draw_x0;
+	}
+	scaled = screen_font(font, draw_level);
+	if(scaled == NULL)
+		greek_text(s, font, colour->pens->item(colour_index), surface, x, y);
+	else
+	{
+		render_text(s, scaled, colour_index, surface, draw_x(x),
+				draw_y(y), to_draw_coords(underlined));
 	}
+	measure_text(font, s, &w, &h); // Keep to the layout from calc_width()
+	return x + w;
+}
+
+void draw_backdrop(style *st, SDL_Surface *surface, int x1, int y1,
+		int x2, int y2)
+{
+	/* Draws the style's background picture, stretched over (x1, y1)-(x2,
+		y2) on surface, or its texture repeated from there; but only where
+		it is inside the clip rectangle, so a tile or a redrawn region costs
+		no more than its own size: */
+	SDL_Rect clip, part, dst;
+	SDL_Surface *sheet;
+	int cx1, cy1, cx2, cy2;
 
-	// Draw background image or texture:
+	SDL_GetClipRect(surface, &clip);
+	cx1 = x1 > clip.x ? x1 : clip.x;
+	cy1 = y1 > clip.y ? y1 : clip.y;
+	cx2 = x2 < clip.x + clip.w ? x2 : clip.x + clip.w;
+	cy2 = y2 < clip.y + clip.h ? y2 : clip.y + clip.h;
+	if(!clip_to_surface(&part, cx1, cy1, cx2, cy2, surface))
+		return;
 	if(st->background != NULL)
 	{
-		int src_w, src_h, dst_w, dst_h;
-		SDL_Surface *scaled;
-		SDL_Rect dst;
-		
-		// Scale background image to fit this slide:
-		src_w = st->background->w;
-		src_h = st->background->h;
-		dst_w = sl->des_w;
-		if(st->bgbar || !st->enablebar)
-		{
-			dst_h = sl->des_h;
-			dst.y = 0;
-		}
-		else
-		{
-			dst_h = sl->des_h - (st->titlespacing - TITLE_EDGE);
-			dst.y = st->titlespacing - TITLE_EDGE;
-		}
-		scaled = zoomSurface(st->background, (double)dst_w / (double)src_w,
-				(double)dst_h / (double)src_h, 1);
-		
-		// Blit:
-		dst.x = 0;
-		SDL_BlitSurface(scaled, NULL, surface, &dst);
-	
-		SDL_FreeSurface(scaled);
+		dst = part;
+		dst.x -= x1; // The part of the stretched picture
+		dst.y -= y1;
+		blit_fitted(st->background, x2 - x1, y2 - y1, &dst, surface,
+				part.x, part.y);
+		return;
 	}
-	else if(st->texture != NULL)
+	// Whole sheets, in line with the copies of the texture from (x1, y1):
+	sheet = tiled_png(st->texture, draw_level);
+	SDL_SetClipRect(surface, &part);
+	for(int y = y1 + (part.y - y1) / sheet->h * sheet->h;
+			y < part.y + part.h; y += sheet->h)
 	{
-		SDL_Rect dst;
-		int w, h;
-		int xrepeats, yrepeats;
-		int vert_offset;
-		
-		w = st->texture->w;
-		h = st->texture->h;
-		if(st->bgbar || !st->enablebar)
-			vert_offset = 0;
-		else
-			vert_offset = st->titlespacing - TITLE_EDGE;
-		xrepeats = SCREEN_WIDTH / w;
-		if(SCREEN_WIDTH % w > 0)
-			xrepeats++;
-		yrepeats = (SCREEN_HEIGHT - vert_offset) / h;
-		if((SCREEN_HEIGHT - vert_offset) % h > 0)
-			yrepeats++;
-		for(int x = 0; x < xrepeats; x++)
+		for(int x = x1 + (part.x - x1) / sheet->w * sheet->w;
+				x < part.x + part.w; x += sheet->w)
 		{
-			for(int y = 0; y < yrepeats; y++)
-			{
-				dst.x = x * w;
-				dst.y = vert_offset + y * h;
-				SDL_BlitSurface(st->texture, NULL, surface, &dst);
-			}
+			dst.x = x;
+			dst.y = y;
+			SDL_BlitSurface(sheet, NULL, surface, &dst);
 		}
 	}
+	SDL_SetClipRect(surface, &clip);
+}
+
+void render_background(slide *sl, SDL_Surface *surface)
+{
+	SDL_Rect dst;
+	style *st = sl->st;
+	int bar_h = to_draw_coords(st->titlespacing - TITLE_EDGE);
+	// The whole slide, wherever the surface is on it:
+	int x1 = draw_x(0), y1 = draw_y(0);
+	int x2 = draw_x(sl->des_w), y2 = draw_y(sl->des_h);
+	
+	// Set slide area to the background colour:
+	SDL_FillRect(surface, NULL, colour->fills->item(st->bgcolour));
+
+	// Fill in the	titlebar area:
+	if(st->enablebar && clip_to_surface(&dst, x1, y1, x2, y1 + bar_h, surface))
+		SDL_FillRect(surface, &dst, colour->fills->item(st->barcolour));
+
+	// Draw background image or texture, cut to the slide's size:
+	if(st->background != NULL || st->texture != NULL)
+		draw_backdrop(st, surface, x1, y1 +
+				((st->bgbar || !st->enablebar) ? 0 : bar_h), x2, y2);
 	
 	// Draw the slide border:
-	for(int i = 0; i < st->slideborder; i++)
+	for(int i = 0; i < draw_thickness(st->slideborder); i++)
 	{
-		rectangleColor(surface, i, i, sl->des_w - 1 - i, sl->des_h - 1 - i,
+		rectangleColor(surface, x1 + i, y1 + i, x2 - 1 - i, y2 - 1 - i,
 				colour->pens->item(st->bordercolour));
 	}
 	
@@ -525,20 +682,21 @@ void render_background(slide *sl, SDL_Surface *surface)
 		char *title = sl->content->line;
 		int xbase = st->leftmargin + st->foldmargin;
 		
-		for(int i = 0; i < st->barborder; i++)
+		for(int i = 0; i < draw_thickness(st->barborder); i++)
 		{
-			hlineColor(surface, 1, sl->des_w - 2,
-					st->titlespacing - TITLE_EDGE - 1 + i,
+			hlineColor(surface, x1 + 1, x2 - 2,
+					draw_y(st->titlespacing - TITLE_EDGE - 1) + i,
 					colour->pens->item(st->bordercolour));
 		}
 
-		render_text(title, st->title_font, colour->inks->item(st->titlecolour),
+		slide_text(title, st->title_font, st->titlecolour,
 				surface, xbase, (st->titlespacing - TITLE_EDGE -
-				(st->title_ascent - st->title_descent)) / 2 - 1 + st->topmargin);
+				(st->title_ascent - st->title_descent)) / 2 - 1 + st->topmargin,
+				0);
 	}
 }
 
-void render_line(slide *sl, displayline *out, DrawMode *dm,
+void draw_line(slide *sl, displayline *out, DrawMode *dm,
 		SDL_Surface *surface)
 {
 	style *st = sl->st;
@@ -630,9 +788,22 @@ void render_line(slide *sl, displayline *out, DrawMode *dm,
 	{
 		SDL_Rect dst;
 
-		dst.x = x;
-		dst.y = out->y + st->latexspaceabove;
-		SDL_BlitSurface(out->import, NULL, surface, &dst);
+		dst.x = draw_x(x);
+		dst.y = draw_y(out->y + st->latexspaceabove);
+		if(draw_p != draw_q)
+		{
+			/* Latex output comes at the design size, so is resized for
+				each level once, as pictures are by screen_png(): */
+			if(out->scaled_import[draw_level] == NULL)
+			{
+				out->scaled_import[draw_level] = zoom_surface(out->import,
+						(double)draw_p / (double)draw_q, MEM_LATEX, sl);
+			}
+			SDL_BlitSurface(out->scaled_import[draw_level], NULL, surface,
+					&dst);
+		}
+		else
+			SDL_BlitSurface(out->import, NULL, surface, &dst);
 	}
 	else if(out->rule)
 	{
@@ -641,17 +812,17 @@ void render_line(slide *sl, displayline *out, DrawMode *dm,
 		
 		width = sl->des_w * st->rulewidth / 100;
 		
-		dst.x = (sl->des_w - width) / 2;
-		dst.y = out->y + st->rulespaceabove;
-		dst.w = width;
-		dst.h = st->ruleheight;
+		dst.x = draw_x((sl->des_w - width) / 2);
+		dst.y = draw_y(out->y + st->rulespaceabove);
+		dst.w = to_draw_coords(width);
+		dst.h = to_draw_coords(st->ruleheight);
 		SDL_FillRect(surface, &dst, colour->fills->item(st->rulecolour));
 	}
 	else if(out->line == NULL)
 		error("Impossible out->line in render.cpp");
 	else if(out->heading && strlen(out->line) > 0)
 	{
-		x = render_text(out->line, st->heading_font,
+		x = slide_text(out->line, st->heading_font,
 				st->headingcolour, surface,
 				x, out->y + st->headspaceabove, 0);
 	}
@@ -694,7 +865,7 @@ void render_line(slide *sl, displayline *out, DrawMode *dm,
 				{
 					font = st->text_font;
 				}
-				x = render_text(s, font,
+				x = slide_text(s, font,
 						out->link == NULL ? dm->current_text_colour_index :
 						link_text_colour_index, surface, x,
 						out->y + textshift,
@@ -733,7 +904,7 @@ void render_line(slide *sl, displayline *out, DrawMode *dm,
 				if(dm->ttmode == 0)
 					dm->boldmode = 1 - dm->boldmode;
 				else
-					x = render_text("*", st->fixed_font,
+					x = slide_text("*", st->fixed_font,
 						out->link == NULL ? dm->current_text_colour_index :
 						link_text_colour_index, surface, x,
 						out->y + st->text_ascent - st->fixed_ascent,
@@ -745,7 +916,7 @@ void render_line(slide *sl, displayline *out, DrawMode *dm,
 				if(dm->ttmode == 0)
 					dm->italicmode = 1 - dm->italicmode;
 				else
-					x = render_text("/", st->fixed_font,
+					x = slide_text("/", st->fixed_font,
 						out->link == NULL ? dm->current_text_colour_index :
 						link_text_colour_index, surface, x,
 						out->y + st->text_ascent - st->fixed_ascent,
@@ -758,12 +929,14 @@ void render_line(slide *sl, displayline *out, DrawMode *dm,
 	}
 
 	if(debug & DEBUG_BASELINES)
-	{		
-		pixelColor(surface, xbase, out->y, colour->red_pen);
-		pixelColor(surface, xbase - 1, out->y - 1, colour->red_pen);
-		pixelColor(surface, xbase + 1, out->y + 1, colour->red_pen);
-		pixelColor(surface, xbase - 1, out->y + 1, colour->red_pen);
-		pixelColor(surface, xbase + 1, out->y - 1, colour->red_pen);
+	{
+		int bx = draw_x(xbase), by = draw_y(out->y);
+
+		pixelColor(surface, bx, by, colour->red_pen);
+		pixelColor(surface, bx - 1, by - 1, colour->red_pen);
+		pixelColor(surface, bx + 1, by + 1, colour->red_pen);
+		pixelColor(surface, bx - 1, by + 1, colour->red_pen);
+		pixelColor(surface, bx + 1, by - 1, colour->red_pen);
 	}
 
 	if(single_line)
@@ -776,110 +949,114 @@ void draw_logos(slide *sl, style *st, SDL_Surface *surface)
 {
 	SDL_Rect dst;
 	logo *lo;
+	SDL_Surface *image;
 
 	for(int i = 0; i < st->logos->count(); i++)
 	{
 		lo = st->logos->item(i);
+		image = render_icon(lo->image);
 		if(lo->x < 0)
-			dst.x = sl->des_w + lo->x - lo->image->w;
+			dst.x = draw_x(sl->des_w + lo->x) - image->w;
 		else
-			dst.x = lo->x;
+			dst.x = draw_x(lo->x);
 		if(lo->y < 0)
-			dst.y = sl->des_h + lo->y - lo->image->h;
+			dst.y = draw_y(sl->des_h + lo->y) - image->h;
 		else
-			dst.y = lo->y;
-		SDL_BlitSurface(lo->image, NULL, surface, &dst);
+			dst.y = draw_y(lo->y);
+		blend_blit(image, NULL, surface, &dst);
 	}
 }
 
 void reallocate_surfaces(slide *sl)
 {
-	if(scalep != 1)
-	{
-		if(sl->scaled != NULL)
-			SDL_FreeSurface(sl->scaled);
-		sl->scaled = NULL; // Paranoia
-	}	
+	free_tiles(sl);
+
 	if(sl->mini != NULL)
 	{
-		SDL_FreeSurface(sl->mini);
+		free_surface(sl->mini);
 		sl->mini = NULL; // Paranoia
 	}
-	if(sl->micro != NULL)
-	{
-		SDL_FreeSurface(sl->micro);
-		sl->micro = NULL; // Paranoia
-	}
-	// Should we delete the mini decor here??? - XXX
+	free_micro(sl);
+	free_decoration_set(&sl->mini_decor); // scale() makes these again
+}
+
+int tiled_slide(slide *sl)
+{
+	/* Slides bigger than the screen, when the render surface would be at
+		screen resolution, have no render surface: their full size level is
+		drawn a tile at a time as it comes into view, so it costs memory and
+		time in proportion to what is seen rather than to the slide. Only
+		showing a whole slide at once (as a single slide view, say) draws
+		it all. HTML export always wants the whole bitmap: */
+	return sl->image_file == NULL && !export_html &&
+			(scalep == 1 || direct_rendering()) &&
+			(sl->scr_w > SCREEN_WIDTH || sl->scr_h > SCREEN_HEIGHT);
+}
+
+int zoomed_directly(slide *sl)
+{
+	// Whether the mini and micro levels are drawn rather than reduced
+	return (options->directzoom || tiled_slide(sl)) && sl->image_file == NULL;
+}
+
+SDL_Surface *draw_zoomed(slide *sl, int level)
+{
+	// Draws the slide straight from its display list at a zoomed out level
+	SDL_Surface *surface;
+
+	set_draw_level(level);
+	surface = alloc_surface(to_draw_coords(sl->des_w),
+			to_draw_coords(sl->des_h), MEM_ZOOMED, sl);
+	draw_slide(sl, surface);
+	return surface;
 }
 
 void scale(slide *sl)
 {
 	double f;
 	
-	if(scalep == 1)
-		sl->scaled = sl->render;
+	/* The screen resolution level isn't made here: copy_scaled() scales
+		it from the render surface (or for a tiled slide draws it) a tile
+		at a time, as it comes into view, unless the render surface is at
+		screen resolution already.
+		Create zoomed out version of everything we've just drawn, or with
+		the directzoom option draw them afresh. Card edges are always put
+		together afresh from their sprites, at the mini level's size: */
+	if(sl->mini != NULL)
+		error("Paranoia: mini surface not freed up");
+	if(sl->micro != NULL)
+		error("Paranoia: micro surface not freed up");
+	if(zoomed_directly(sl))
+	{
+		sl->mini = draw_zoomed(sl, 1);
+		sl->micro = draw_zoomed(sl, 2);
+	}
 	else
 	{
-		if(sl->scaled != NULL)
-			error("Paranoia: scaled surface not freed up");
-		f = (double)scalep / (double)scaleq;
-		sl->scaled = zoomSurface(sl->render, f, f, 1);
-		if(sl->scaled == NULL)
-			error("zoomSurface returned NULL");
+		f = render_zoom() / 3.0;
+		// sl->mini = SDL_ResizeFactor(sl->scaled, (float)f, 1);
+		sl->mini = zoom_surface(sl->render, f, MEM_ZOOMED, sl);
 	}
 	
-	// Create zoomed out version of everything we've just drawn:
-	f = 1.0 / 3.0;
-	if(sl->mini != NULL)
-		error("Paranoia: mini surface not freed up");
-	// sl->mini = SDL_ResizeFactor(sl->scaled, (float)f, 1);
-	sl->mini = zoomSurface(sl->scaled, f, f, 1);
-	if(sl->mini == NULL)
-		error("zoomSurface returned NULL");
-	
 	if(sl->deck_size > 1)
-	{
-		if(sl->decor.top != NULL)
-			sl->mini_decor.top = zoomSurface(sl->decor.top, f, f, 1);
-		if(sl->decor.bottom != NULL)
-			sl->mini_decor.bottom = zoomSurface(sl->decor.bottom, f, f, 1);
-		if(sl->decor.left != NULL)
-			sl->mini_decor.left = zoomSurface(sl->decor.left, f, f, 1);
-		if(sl->decor.right != NULL)
-			sl->mini_decor.right = zoomSurface(sl->decor.right, f, f, 1);
-	}
+		compose_decorations(sl, &sl->mini_decor, 1, sl->mini->w,
+				sl->mini->h);
 	
-	if(sl->micro != NULL)
-		error("Paranoia: micro surface not freed up");
-	sl->micro = zoomSurface(sl->mini, f, f, 1);
+	f = 1.0 / 3.0;
 	if(sl->micro == NULL)
-		error("zoomSurface returned NULL");
+		sl->micro = zoom_surface(sl->mini, f, MEM_ZOOMED, sl);
+	sl->micro = pack_micro(sl->micro, sl);
+	damage_overview(sl);
 }
 
-void render_slide(slide *sl)
+void draw_slide(slide *sl, SDL_Surface *surface)
 {
-	/* Returns a specially allocated surface only if the "except"
-		subimage != NULL; otherwise uses the slide's built-in render surface. */
-	
+	// Draws everything on the slide, at the current draw level
 	style *st = sl->st;
 	displaylinevector *repr = sl->repr;
 	displayline *out;
 	DrawMode *dm;
-	SDL_Surface *surface;
 
-	if(export_html == 1)
-		printf("Rendering %s\n", sl->content->line);	
-	if(sl->image_file != NULL)
-		return;
-	
-	if(sl->render != NULL)
-		SDL_FreeSurface(sl->render);
-	sl->render = alloc_surface(sl->des_w, sl->des_h);
-	
-	reallocate_surfaces(sl);
-	surface = sl->render;
-		
 	render_background(sl, surface);
 	
 	// Render the text lines:	
@@ -890,7 +1067,7 @@ void render_slide(slide *sl)
 	for(int i = 0; i < repr->count(); i++)
 	{
 		out = repr->item(i);
-		render_line(sl, out, dm, surface);
+		draw_line(sl, out, dm, surface);
 	}
 	delete dm;
 	
@@ -901,21 +1078,285 @@ void render_slide(slide *sl)
 	for(int i = 0; i < sl->visible_images->count(); i++)
 	{
 		img = sl->visible_images->item(i);
+		if(img == dragged)
+			continue; // Drawn over the slide instead, by copy_dragged()
 		if(img->surface == NULL)
 			load_subimage(img);
 		draw_subimage(surface, img);
 	}
+}
+
+void render_full(slide *sl)
+{
+	// Draws the full size level, and the mini and micro levels from it
+	if(sl->render != NULL)
+		free_surface(sl->render);
+	set_draw_level(render_level());
+	sl->render = alloc_surface(to_draw_coords(sl->des_w),
+			to_draw_coords(sl->des_h), MEM_SLIDES, sl);
+	reallocate_surfaces(sl);
+	draw_slide(sl, sl->render);
 	if(sl->deck_size > 1)
 		render_decorations(sl);
-
 	scale(sl);
 }
 
+void render_slide(slide *sl)
+{
+	if(export_html == 1)
+		printf("Rendering %s\n", sl->content->line);	
+	if(sl->image_file != NULL)
+		return;
+	
+	discard_packed(sl); // Any compressed copy is out of date now
+	if(tiled_slide(sl) ||
+			(zoomed_directly(sl) && !(zoom_level == 0 && slide_in_view(sl))))
+	{
+		/* Only the zoomed out levels are needed for now, and are drawn
+			directly; the full size level waits until it is looked at, or
+			for a tiled slide is drawn tile by tile as it is: */
+		if(sl->render != NULL)
+			free_surface(sl->render);
+		sl->render = NULL;
+		free_tiles(sl);
+		if(tiled_slide(sl) && sl->deck_size > 1)
+			render_decorations(sl);
+		else
+			free_decorations(sl);
+		reallocate_surfaces(sl);
+		scale(sl);
+		return;
+	}
+	render_full(sl);
+}
+
+int clip_to_surface(SDL_Rect *r, int x1, int y1, int x2, int y2,
+		SDL_Surface *surface)
+{
+	// Sets r to (x1, y1)-(x2, y2) within surface; false if nothing is left
+	if(x1 < 0) x1 = 0;
+	if(y1 < 0) y1 = 0;
+	if(x2 > surface->w) x2 = surface->w;
+	if(y2 > surface->h) y2 = surface->h;
+	if(x2 <= x1 || y2 <= y1)
+		return 0;
+	r->x = x1;
+	r->y = y1;
+	r->w = x2 - x1;
+	r->h = y2 - y1;
+	return 1;
+}
+
+int draw_region(slide *sl, SDL_Surface *surface, int level, SDL_Rect *area,
+		SDL_Rect *drawn)
+{
+	/* Like draw_slide(), but only inside area (in design co-ordinates).
+		Lines outside it are skipped, and the rest drawn on their own from
+		their initial draw modes, so the cost follows the area's size: */
+	displayline *out;
+	subimage *img;
+	int y1, y2;
+
+	set_draw_level(level);
+	if(!clip_to_surface(drawn, draw_x(area->x), draw_y(area->y),
+			draw_x(area->x + area->w) + 1, draw_y(area->y + area->h) + 1,
+			surface))
+		return 0;
+	SDL_SetClipRect(surface, drawn);
+	render_background(sl, surface);
+	for(int i = 0; i < sl->repr->count(); i++)
+	{
+		out = sl->repr->item(i);
+		y1 = out->y - 10; // Fold icons may stand out
+		y2 = out->y + out->height + 10;
+		if(y2 > area->y && y1 < area->y + area->h)
+			draw_line(sl, out, NULL, surface);
+	}
+	draw_logos(sl, sl->st, surface);
+	for(int i = 0; i < sl->visible_images->count(); i++)
+	{
+		img = sl->visible_images->item(i);
+		if(img == dragged)
+			continue; // Drawn over the slide instead, by copy_dragged()
+		if(img->surface == NULL)
+			load_subimage(img);
+		draw_subimage(surface, img);
+	}
+	SDL_SetClipRect(surface, NULL);
+	return 1;
+}
+
+void reduce_block(SDL_Surface *src, double f, SDL_Surface *dst,
+		SDL_Rect *block)
+{
+	/* Reduces the part of src under block (in dst, which is f times the
+		size of src) in place. As for tiles, a few pixels either side are
+		included so that the smoothing matches the pixels around it: */
+	const int pad = 2;
+	SDL_Surface *part, *zoomed;
+	SDL_Rect from, cut, to;
+
+	if(!clip_to_surface(&from, (int)(block->x / f) - pad,
+			(int)(block->y / f) - pad, (int)((block->x + block->w) / f) + pad,
+			(int)((block->y + block->h) / f) + pad, src))
+		return;
+	part = alloc_surface(from.w, from.h, MEM_OSD);
+	SDL_BlitSurface(src, &from, part, NULL);
+	zoomed = zoomSurface(part, f, f, 1);
+	if(zoomed == NULL)
+		error("zoomSurface returned NULL");
+	cut.x = block->x - (int)((double)from.x * f + 0.5);
+	cut.y = block->y - (int)((double)from.y * f + 0.5);
+	cut.w = block->w;
+	cut.h = block->h;
+	to.x = block->x;
+	to.y = block->y;
+	SDL_BlitSurface(zoomed, &cut, dst, &to);
+	SDL_FreeSurface(zoomed);
+	free_surface(part);
+}
+
+void reduce_region(SDL_Surface *src, SDL_Rect *r, double f, SDL_Surface *dst,
+		SDL_Rect *block)
+{
+	// The block of dst covering r on src, widened to whole pixels, reduced
+	block->w = block->h = 0;
+	if(r->w > 0 && clip_to_surface(block, (int)(r->x * f), (int)(r->y * f),
+			(int)((r->x + r->w) * f) + 1, (int)((r->y + r->h) * f) + 1, dst))
+		reduce_block(src, f, dst, block);
+}
+
+void damage_tiles(slide *sl, SDL_Rect *area)
+{
+	// Drops the screen resolution tiles over area, to be scaled again
+	slide_tiles *t = sl->tiles;
+	int x1, y1, x2, y2;
+
+	if(t == NULL)
+		return;
+	x1 = to_screen_coords(area->x - 2) / TILE_SIZE;
+	y1 = to_screen_coords(area->y - 2) / TILE_SIZE;
+	x2 = to_screen_coords(area->x + area->w + 2) / TILE_SIZE;
+	y2 = to_screen_coords(area->y + area->h + 2) / TILE_SIZE;
+	for(int row = y1 > 0 ? y1 : 0; row <= y2 && row < t->rows; row++)
+	{
+		for(int col = x1 > 0 ? x1 : 0; col <= x2 && col < t->cols; col++)
+		{
+			if(t->tile[row * t->cols + col] != NULL)
+				free_surface(t->tile[row * t->cols + col]);
+			t->tile[row * t->cols + col] = NULL;
+		}
+	}
+}
+
+void redraw_region(slide *sl, SDL_Rect *area)
+{
+	/* Redraws just the part of a slide inside area (in design co-ordinates)
+		after a change confined to it, in place on each level the slide
+		has. The mini level is reduced again only over the block matching
+		what was redrawn, and the micro level over the block matching that
+		(on the 3:1 grid between them): */
+	SDL_Rect drawn, block, micro_block;
+
+	if(sl->image_file != NULL || area->w <= 0 || area->h <= 0)
+		return;
+	discard_packed(sl);
+	if(sl->mini != NULL && sl->render == NULL && !zoomed_directly(sl))
+	{
+		// Can't reduce from the full size level, so draw it all:
+		render_full(sl);
+		return;
+	}
+	damage_tiles(sl, area); // Scaled or drawn again when next seen
+	if(sl->render != NULL && draw_region(sl, sl->render, render_level(),
+			area, &drawn))
+	{
+		if(sl->mini != NULL && !zoomed_directly(sl))
+		{
+			reduce_region(sl->render, &drawn, render_zoom() / 3.0, sl->mini,
+					&block);
+			reduce_region(sl->mini, &block, 1.0 / 3.0, sl->micro,
+					&micro_block);
+		}
+	}
+	if(sl->mini != NULL && zoomed_directly(sl))
+	{
+		draw_region(sl, sl->mini, 1, area, &drawn);
+		draw_region(sl, sl->micro, 2, area, &drawn);
+	}
+	damage_overview(sl);
+}
+
+void image_area(subimage *img, SDL_Rect *area)
+{
+	area->x = img->des_x;
+	area->y = img->des_y;
+	area->w = img->des_w;
+	area->h = img->des_h;
+}
+
+void drag_image(slide *sl, subimage *img)
+{
+	/* Redraws the slide once without img, which is then drawn over the
+		slide as it is copied to the screen until it is dropped, so moving
+		it costs a blit rather than a redraw. NULL forgets any drag: */
+	SDL_Rect area;
+
+	dragged_slide = sl;
+	dragged = img;
+	if(sl == NULL)
+		return;
+	image_area(img, &area);
+	redraw_region(sl, &area);
+}
+
+void drop_image()
+{
+	// Puts the dragged image back on its slide, where it has been left
+	slide *sl = dragged_slide;
+	SDL_Rect area;
+	int w, h;
+
+	if(sl == NULL)
+		return;
+	image_area(dragged, &area);
+	dragged_slide = NULL;
+	dragged = NULL;
+	w = sl->des_w;
+	h = sl->des_h;
+	measure_slide(sl); // The slide grows to take in embedded images
+	if(sl->des_w == w && sl->des_h == h)
+		redraw_region(sl, &area);
+	else
+		render_slide(sl);
+}
+
+void copy_dragged(slide *sl, int level, int x, int y)
+{
+	// Draws the dragged image, if it is on sl, with the slide at (x, y)
+	SDL_Surface *image;
+	SDL_Rect bounds, dst;
+
+	if(sl != dragged_slide || sl == NULL)
+		return;
+	if(dragged->surface == NULL)
+		load_subimage(dragged);
+	image = screen_png(dragged->surface, level);
+	bounds.x = x;
+	bounds.y = y;
+	bounds.w = sl->scr_w / zoom_factor(level);
+	bounds.h = sl->scr_h / zoom_factor(level);
+	dst.x = x + dragged->scr_x / zoom_factor(level);
+	dst.y = y + dragged->scr_y / zoom_factor(level);
+	SDL_SetClipRect(screen, &bounds); // Kept within the slide, as when drawn
+	blend_blit(image, NULL, screen, &dst);
+	SDL_SetClipRect(screen, NULL);
+}
+
 void load_subimage(subimage *img)
 {
-	img->surface = load_png(img->path_name, 1);
-	if(img->surface == NULL)
-		error("Can't load image %s", img->path_name);
+	// Shared with any other slides using the same picture:
+	img->surface = share_png(img->path_name, 1, MEM_SUBIMAGES);
 	img->des_w = img->surface->w;
 	img->des_h = img->surface->h;
 	img->scr_w = to_screen_coords(img->des_w);
@@ -925,33 +1366,33 @@ void load_subimage(subimage *img)
 void draw_subimage(SDL_Surface *target, subimage *img)
 {
 	SDL_Rect dst;
-	dst.x = img->des_x;
-	dst.y = img->des_y;
+	dst.x = draw_x(img->des_x);
+	dst.y = draw_y(img->des_y);
 	if(img->surface == NULL || target == NULL)
 		error("Tried to render a NULL surface in draw_subimage");
-	int ret = SDL_BlitSurface(img->surface, NULL, target, &dst);
+	int ret = blend_blit(render_icon(img->surface), NULL, target, &dst);
 	if(ret != 0)
-		error("SDL_BlitSurface failed in draw_subimage()");
+		error("blend_blit failed in draw_subimage()");
 }
 
 void free_decorations(slide *sl)
 {
 	if(sl->decor.top != NULL)
-		SDL_FreeSurface(sl->decor.top);
+		free_surface(sl->decor.top);
 	if(sl->decor.bottom != NULL)
-		SDL_FreeSurface(sl->decor.bottom);
+		free_surface(sl->decor.bottom);
 	if(sl->decor.left != NULL)
-		SDL_FreeSurface(sl->decor.left);
+		free_surface(sl->decor.left);
 	if(sl->decor.right != NULL)
-		SDL_FreeSurface(sl->decor.right);
+		free_surface(sl->decor.right);
 	if(sl->mini_decor.top != NULL)
-		SDL_FreeSurface(sl->mini_decor.top);
+		free_surface(sl->mini_decor.top);
 	if(sl->mini_decor.bottom != NULL)
-		SDL_FreeSurface(sl->mini_decor.bottom);
+		free_surface(sl->mini_decor.bottom);
 	if(sl->mini_decor.left != NULL)
-		SDL_FreeSurface(sl->mini_decor.left);
+		free_surface(sl->mini_decor.left);
 	if(sl->mini_decor.right != NULL)
-		SDL_FreeSurface(sl->mini_decor.right);
+		free_surface(sl->mini_decor.right);
 	
 	sl->decor.top = sl->decor.bottom = NULL;
 	sl->decor.left = sl->decor.right = NULL;
@@ -959,164 +1400,106 @@ void free_decorations(slide *sl)
 	sl->mini_decor.left = sl->mini_decor.right = NULL;
 }
 
-void render_decorations(slide *sl)
+void compose_decorations(slide *sl, decorations *d, int level, int w, int h)
 {
-	int x1, y1;
-	int below, above;
-	SDL_Rect dst;
+	/* Puts together the edges of the cards behind and in front of this
+		one, at a draw level where the slide is w x h, from the pieces in
+		the sprite cache: */
+	card_look look;
+	card_sprites *cs;
 	style *st = sl->st;
-	Uint32 border_pen = colour->pens->item(st->bordercolour);
+	int below, above, e, b, head, x1, y1;
 
-	free_decorations(sl);
-		
+	set_draw_level(level);
+	memset(&look, 0, sizeof(card_look));
+	e = CARD_EDGE / zoom_factor(level);
+	if(e < 1)
+		e = 1;
+	b = draw_thickness(st->slideborder);
+	look.edge = e;
+	look.border = b;
+	look.border_fill = colour->fills->item(st->bordercolour);
+	look.body_fill = colour->fills->item(st->bgcolour);
+	look.seen_fill = colour->light_grey_fill;
+	if(st->enablebar)
+	{
+		look.bar_h = to_draw_coords(st->titlespacing - TITLE_EDGE);
+		look.rule_y = to_draw_coords(st->titlespacing - TITLE_EDGE - 1);
+		look.rule_h = draw_thickness(st->barborder);
+		look.bar_fill = colour->fills->item(st->barcolour);
+	}
+	else
+		look.bar_fill = look.body_fill;
+	cs = find_card_sprites(&look);
+	head = card_head(&look);
+	
 	below = sl->deck_size - sl->card;
 	above = sl->card - 1;	
 	
 	if(below > 0)
 	{
-		sl->decor.top = alloc_surface(sl->scr_w, CARD_EDGE * below);
-		sl->decor.right = alloc_surface(CARD_EDGE * below,
-				sl->scr_h + CARD_EDGE * below);
-		clear_surface(sl->decor.top, colour->grey_fill);
-		clear_surface(sl->decor.right, colour->grey_fill);
+		d->top = alloc_surface(w, e * below, MEM_DECORATIONS, sl);
+		d->right = alloc_surface(e * below, h + e * below, MEM_DECORATIONS, sl);
+		clear_surface(d->top, colour->grey_fill);
+		clear_surface(d->right, colour->grey_fill);
 		for(int i = 0; i < below; i++)
 		{
-			// Top edge:
-			x1 = CARD_EDGE * (i + 1);
-			y1 = CARD_EDGE * (below - i - 1);
-			dst.x = x1;
-			dst.y = y1;
-			dst.w = sl->scr_w - x1;
-			dst.h = CARD_EDGE;
-			SDL_FillRect(sl->decor.top, &dst,
-					st->enablebar ? colour->fills->item(st->barcolour)
-					: colour->fills->item(st->bgcolour));
-			for(int j = 0; j < st->slideborder; j++)
-			{
-				hlineColor(sl->decor.top, x1 + j, sl->scr_w - 1, y1 + j,
-						border_pen);
-				vlineColor(sl->decor.top, x1 + j, y1 + j, y1 + CARD_EDGE - 1,
-						border_pen);
-			}
+			// Top edge, carrying on round the top right corner:
+			x1 = e * (i + 1);
+			y1 = e * (below - i - 1);
+			tile_sprite(cs->behind_band, 0, 0, b, e, d->top, x1, y1, b, e);
+			tile_sprite(cs->behind_band, b, 0, CARD_STRIP, e,
+					d->top, x1 + b, y1, w - x1 - b, e);
+			tile_sprite(cs->behind_band, b, 0, CARD_STRIP, e,
+					d->right, 0, y1, e * i, e);
 
-			// Top-right corner:
-			x1 = 0;
-			y1 = CARD_EDGE * (below - i - 1);
-			dst.x = x1;
-			dst.y = y1;
-			dst.w = CARD_EDGE * i;
-			dst.h = CARD_EDGE;
-			SDL_FillRect(sl->decor.right, &dst,
-					st->enablebar ? colour->fills->item(st->barcolour)
-					: colour->fills->item(st->bgcolour));
-			for(int j = 0; j < st->slideborder; j++)
-			{
-				hlineColor(sl->decor.right, 0, CARD_EDGE * (i + 1) - 1,
-						y1 + j, border_pen);
-			}
-			
-			// Right edge:
-			x1 = CARD_EDGE * i;
-			y1 = CARD_EDGE * (below - i - 1);
-			dst.x = x1;
-			dst.y = y1 + st->slideborder;
-			dst.w = CARD_EDGE;
-			dst.h = sl->scr_h - st->slideborder;
-			SDL_FillRect(sl->decor.right, &dst, colour->fills->item(st->bgcolour));
-			for(int j = 0; j < st->slideborder; j++)
-			{
-				vlineColor(sl->decor.right, x1 + CARD_EDGE - 1 - j,
-						y1, y1 + sl->scr_h - 1, border_pen);
-				hlineColor(sl->decor.right, x1, x1 + CARD_EDGE - 1,
-						y1 + sl->scr_h - 1 - j, border_pen);
-			}
-			
-			// Titlebar area:
-			if(st->enablebar)
-			{
-				x1 = CARD_EDGE * i;
-				y1 = CARD_EDGE * (below - i - 1) + st->slideborder;
-				dst.x = x1;
-				dst.y = y1;
-				dst.w = CARD_EDGE - st->slideborder;
-				dst.h = to_screen_coords(st->titlespacing - TITLE_EDGE) -
-						st->slideborder;
-				SDL_FillRect(sl->decor.right, &dst,
-						colour->fills->item(st->barcolour));
-			}
-			
-			// Dividing line below bar:
-			x1 = CARD_EDGE * i;
-			y1 = CARD_EDGE * (below - i - 1);
-			if(st->enablebar)
-			{
-				for(int j = 0; j < st->barborder; j++)
-				{
-					hlineColor(sl->decor.right, x1, x1 + CARD_EDGE - 1,
-							y1 +
-							to_screen_coords(st->titlespacing - TITLE_EDGE - 1) + j,
-							colour->pens->item(st->bordercolour));
-				}
-			}
+			// Right edge, with the end of the titlebar:
+			x1 = e * i;
+			tile_sprite(cs->behind_column, 0, 0, e, head,
+					d->right, x1, y1, e, head < h ? head : h);
+			tile_sprite(cs->behind_column, 0, head, e, CARD_STRIP,
+					d->right, x1, y1 + head, e, h - head - b);
+			tile_sprite(cs->behind_column, 0, head + CARD_STRIP, e, b,
+					d->right, x1, y1 + h - b, e, b);
 		}
 	}
 	if(above > 0)
 	{
-		sl->decor.left = alloc_surface(CARD_EDGE * above,
-				sl->scr_h + CARD_EDGE * above);
-		sl->decor.bottom = alloc_surface(sl->scr_w, CARD_EDGE * above);
-		clear_surface(sl->decor.left, colour->grey_fill);
-		clear_surface(sl->decor.bottom, colour->grey_fill);
+		d->left = alloc_surface(e * above, h + e * above, MEM_DECORATIONS, sl);
+		d->bottom = alloc_surface(w, e * above, MEM_DECORATIONS, sl);
+		clear_surface(d->left, colour->grey_fill);
+		clear_surface(d->bottom, colour->grey_fill);
 		for(int i = 0; i < above; i++)
 		{
-			// Bottom edge:
-			x1 = 0;
-			y1 = CARD_EDGE * i;
-			dst.x = x1;
-			dst.y = y1;
-			dst.w = sl->scr_w - CARD_EDGE * (i + 1);
-			dst.h = CARD_EDGE;
-			SDL_FillRect(sl->decor.bottom, &dst, colour->light_grey_fill);
-			for(int j = 0; j < st->slideborder; j++)
-			{
-				hlineColor(sl->decor.bottom, 0,
-						sl->scr_w - CARD_EDGE * (i + 1) - 1,
-						y1 + CARD_EDGE - 1 - j, border_pen);
-				vlineColor(sl->decor.bottom,
-						sl->scr_w - CARD_EDGE * (i + 1) - 1 - j,
-						y1, y1 + CARD_EDGE - 1, border_pen);
-			}
+			// Bottom edge, ending in the bottom right corner:
+			x1 = w - e * (i + 1);
+			y1 = e * i;
+			tile_sprite(cs->seen_band, 0, 0, CARD_STRIP, e,
+					d->bottom, 0, y1, x1 - b, e);
+			tile_sprite(cs->seen_band, CARD_STRIP, 0, b, e,
+					d->bottom, x1 - b, y1, b, e);
 			
-			// Bottom-left corner:
-			x1 = CARD_EDGE * (above - i - 1);
-			y1 = sl->scr_h + CARD_EDGE * i;
-			dst.x = x1;
-			dst.y = y1;
-			dst.w = (i + 1) * CARD_EDGE;
-			dst.h = CARD_EDGE;
-			SDL_FillRect(sl->decor.left, &dst, colour->light_grey_fill);
-			
-			// Left edge:
-			x1 = CARD_EDGE * (above - i - 1);
-			y1 = CARD_EDGE * (i + 1);
-			dst.x = x1;
-			dst.y = y1;
-			dst.w = CARD_EDGE;
-			dst.h = sl->scr_h;
-			SDL_FillRect(sl->decor.left, &dst, colour->light_grey_fill);
-			for(int j = 0; j < st->slideborder; j++)
-			{
-				hlineColor(sl->decor.left, x1, x1 + CARD_EDGE - 1,
-						y1 + j, border_pen);
-				hlineColor(sl->decor.left, x1, x1 + (i + 1) * CARD_EDGE - 1,
-						y1 + sl->scr_h - 1 - j, border_pen);
-				vlineColor(sl->decor.left, x1 + j, y1, y1 + sl->scr_h - 1,
-						border_pen);
-			}
+			// Left edge, and the bottom left corner:
+			x1 = e * (above - i - 1);
+			y1 = e * (i + 1);
+			tile_sprite(cs->seen_column, 0, 0, e, b, d->left, x1, y1, e, b);
+			tile_sprite(cs->seen_column, 0, b, e, CARD_STRIP,
+					d->left, x1, y1 + b, e, h - b - e);
+			tile_sprite(cs->seen_column, 0, b + CARD_STRIP, e, e,
+					d->left, x1, y1 + h - e, e, e);
+			tile_sprite(cs->seen_band, 0, 0, CARD_STRIP, e,
+					d->left, x1 + e, y1 + h - e, e * i, e);
 		}
 	}
 }
 
+void render_decorations(slide *sl)
+{
+	// Card edges at screen resolution (scale() makes the mini level's)
+	free_decorations(sl);
+	compose_decorations(sl, &sl->decor, 0, sl->scr_w, sl->scr_h);
+}
+
 void copy_decorations(slide *sl, int viewx, int viewy)
 {
 	SDL_Rect dst;
@@ -1132,7 +1515,7 @@ void copy_decorations(slide *sl, int viewx, int viewy)
 		
 		if(sl->decor.right != NULL)
 		{
-			dst.x = x1 + sl->scaled->w;
+			dst.x = x1 + sl->scr_w;
 			dst.y = y1 - sl->decor.top->h;
 			SDL_BlitSurface(sl->decor.right, NULL, screen, &dst);
 		}
@@ -1146,7 +1529,7 @@ void copy_decorations(slide *sl, int viewx, int viewy)
 		if(sl->decor.bottom != NULL)
 		{
 			dst.x = x1;
-			dst.y = y1 + sl->scaled->h;
+			dst.y = y1 + sl->scr_h;
 			SDL_BlitSurface(sl->decor.bottom, NULL, screen, &dst);
 		}
 	}
@@ -1251,75 +1634,563 @@ void highlight(slide *sl, int viewx, int viewy, int scale)
 	}
 }
 
+void free_tiles(slide *sl)
+{
+	slide_tiles *t = sl->tiles;
+
+	if(t == NULL)
+		return;
+	for(int i = 0; i < t->cols * t->rows; i++)
+	{
+		if(t->tile[i] != NULL)
+			free_surface(t->tile[i]);
+	}
+	delete[] t->tile;
+	delete t;
+	sl->tiles = NULL;
+}
+
+SDL_Surface *draw_tile(slide *sl, int x, int y, int w, int h)
+{
+	// Draws a tiled slide's tile at (x, y), with the draw origin there
+	SDL_Surface *tile;
+	SDL_Rect area, drawn;
+
+	tile = alloc_surface(w, h, MEM_SLIDES, sl);
+	set_draw_level(render_level());
+	area.x = to_design_coords(x) - 1;
+	area.y = to_design_coords(y) - 1;
+	area.w = to_design_coords(x + w) + 2 - area.x;
+	area.h = to_design_coords(y + h) + 2 - area.y;
+	set_draw_origin(x, y);
+	draw_region(sl, tile, render_level(), &area, &drawn);
+	set_draw_origin(0, 0);
+	return tile;
+}
+
+SDL_Surface *make_tile(slide *sl, int col, int row)
+{
+	/* Draws one tile of a tiled slide, or scales just the part of the
+		render surface under it. When scaling, a few pixels either side are
+		included so that the smoothing matches up with the neighbouring
+		tiles: */
+	const int pad = 2;
+	SDL_Surface *part, *zoomed, *tile;
+	SDL_Rect from, to;
+	double f = (double)scalep / (double)scaleq;
+	int x = col * TILE_SIZE, y = row * TILE_SIZE;
+	int w, h, x2, y2;
+
+	w = sl->scr_w - x < TILE_SIZE ? sl->scr_w - x : TILE_SIZE;
+	h = sl->scr_h - y < TILE_SIZE ? sl->scr_h - y : TILE_SIZE;
+	if(sl->render == NULL)
+		return draw_tile(sl, x, y, w, h);
+	from.x = to_design_coords(x) - pad;
+	from.y = to_design_coords(y) - pad;
+	if(from.x < 0) from.x = 0;
+	if(from.y < 0) from.y = 0;
+	x2 = to_design_coords(x + w) + pad;
+	y2 = to_design_coords(y + h) + pad;
+	if(x2 > sl->render->w) x2 = sl->render->w;
+	if(y2 > sl->render->h) y2 = sl->render->h;
+	from.w = x2 - from.x;
+	from.h = y2 - from.y;
+	
+	part = alloc_surface(from.w, from.h, MEM_SLIDES, sl);
+	SDL_BlitSurface(sl->render, &from, part, NULL);
+	zoomed = zoomSurface(part, f, f, 1);
+	if(zoomed == NULL)
+		error("zoomSurface returned NULL");
+	
+	tile = alloc_surface(w, h, MEM_SLIDES, sl);
+	clear_surface(tile, colour->fills->item(sl->st->bgcolour));
+	from.x = x - (int)((double)from.x * f + 0.5);
+	from.y = y - (int)((double)from.y * f + 0.5);
+	from.w = w;
+	from.h = h;
+	to.x = 0;
+	to.y = 0;
+	SDL_BlitSurface(zoomed, &from, tile, &to);
+	
+	SDL_FreeSurface(zoomed);
+	free_surface(part);
+	return tile;
+}
+
+/* A hyperlink or fold line lit up under the mouse is shown by blitting a
+	lit copy of just that line over the slide, so the slide's own bitmaps
+	are left alone. The copy for each zoom level is made when first shown,
+	by drawing the line lit onto the slide's bitmap and then putting back
+	what was there before. */
+static slide *overlay_slide = NULL;
+static displayline *overlay_line = NULL;
+static SDL_Surface *overlay[ZOOM_LEVELS];
+static int overlay_y[ZOOM_LEVELS]; // Top of each, relative to the slide
+
+void set_overlay(slide *sl, displayline *out)
+{
+	// Lights up a line of a slide, or none if sl is NULL
+	for(int i = 0; i < ZOOM_LEVELS; i++)
+	{
+		if(overlay[i] != NULL)
+			free_surface(overlay[i]);
+		overlay[i] = NULL;
+	}
+	overlay_slide = sl;
+	overlay_line = out;
+}
+
+SDL_Surface *drawn_band(int level, int *y)
+{
+	// As lit_band(), for a tiled slide: the rows are drawn afresh, lit
+	slide *sl = overlay_slide;
+	displayline *out = overlay_line;
+	SDL_Surface *band;
+	SDL_Rect area, drawn;
+	int y2;
+
+	set_draw_level(level);
+	*y = to_draw_coords(out->y - 10); // Fold icons may stand out
+	y2 = to_draw_coords(out->y + out->height + 10);
+	if(*y < 0)
+		*y = 0;
+	if(y2 > to_draw_coords(sl->des_h))
+		y2 = to_draw_coords(sl->des_h);
+	band = alloc_surface(to_draw_coords(sl->des_w), y2 > *y ? y2 - *y : 1,
+			MEM_OSD);
+	area.x = 0;
+	area.y = out->y - 10;
+	area.w = sl->des_w;
+	area.h = out->height + 20;
+	set_draw_origin(0, *y);
+	out->highlighted = 1;
+	draw_region(sl, band, level, &area, &drawn);
+	out->highlighted = 0;
+	set_draw_origin(0, 0);
+	return band;
+}
+
+SDL_Surface *lit_band(SDL_Surface *bitmap, int level, int *y)
+{
+	// Draws the lit line onto bitmap, and takes back the rows it covers
+	slide *sl = overlay_slide;
+	displayline *out = overlay_line;
+	SDL_Surface *saved, *band;
+	SDL_Rect rows;
+	int y2;
+
+	set_draw_level(level);
+	rows.x = 0;
+	rows.y = to_draw_coords(out->y - 10); // Fold icons may stand out
+	y2 = to_draw_coords(out->y + out->height + 10);
+	if(rows.y < 0)
+		rows.y = 0;
+	if(y2 > bitmap->h)
+		y2 = bitmap->h;
+	rows.w = bitmap->w;
+	rows.h = y2 > rows.y ? y2 - rows.y : 1;
+	*y = rows.y;
+	
+	saved = alloc_surface(rows.w, rows.h, MEM_OSD);
+	band = alloc_surface(rows.w, rows.h, MEM_OSD);
+	SDL_BlitSurface(bitmap, &rows, saved, NULL);
+	out->highlighted = 1;
+	draw_line(sl, out, NULL, bitmap);
+	out->highlighted = 0;
+	SDL_BlitSurface(bitmap, &rows, band, NULL);
+	SDL_BlitSurface(saved, NULL, bitmap, &rows);
+	free_surface(saved);
+	return band;
+}
+
+void make_overlay(int level)
+{
+	slide *sl = overlay_slide;
+	SDL_Surface *design;
+	double f;
+	int y;
+
+	if(level == 1)
+		overlay[1] = lit_band(sl->mini, 1, &overlay_y[1]);
+	else if(level == 2)
+		overlay[2] = lit_band(sl->micro, 2, &overlay_y[2]);
+	else if(sl->render == NULL)
+		overlay[0] = drawn_band(render_level(), &overlay_y[0]);
+	else if(scalep == 1 || direct_rendering())
+		overlay[0] = lit_band(sl->render, render_level(), &overlay_y[0]);
+	else
+	{
+		// Lit at the design size, then scaled like the tiles:
+		design = lit_band(sl->render, -1, &y);
+		f = (double)scalep / (double)scaleq;
+		overlay[0] = zoom_surface(design, f, MEM_OSD);
+		overlay_y[0] = to_screen_coords(y);
+		free_surface(design);
+	}
+}
+
+void copy_overlay(slide *sl, int level, int x, int y)
+{
+	// Blits the lit line, if it belongs to sl, with the slide at (x, y)
+	SDL_Rect dst;
+
+	if(sl != overlay_slide || sl == NULL || sl->image_file != NULL)
+		return;
+	if(overlay[level] == NULL)
+		make_overlay(level);
+	dst.x = x;
+	dst.y = y + overlay_y[level];
+	SDL_BlitSurface(overlay[level], NULL, screen, &dst);
+}
+
+void copy_scaled(slide *sl, SDL_Rect *src, SDL_Surface *target, int x, int y)
+{
+	/* Copies part of a slide, at screen resolution, to (x, y) on target.
+		Only the tiles overlapping src are scaled or drawn (if not already),
+		unless the render surface is at screen resolution already: */
+	slide_tiles *t;
+	SDL_Surface *tile;
+	SDL_Rect from, to;
+	int tx, ty, x2, y2;
+
+	if(sl->render == NULL && !tiled_slide(sl))
+		error("Tried to render a NULL surface in copy_scaled");
+	if(sl->render != NULL && (scalep == 1 || direct_rendering()))
+	{
+		from = *src;
+		to.x = x;
+		to.y = y;
+		SDL_BlitSurface(sl->render, &from, target, &to);
+		return;
+	}
+	
+	if(sl->tiles == NULL)
+	{
+		t = new slide_tiles;
+		t->cols = (sl->scr_w + TILE_SIZE - 1) / TILE_SIZE;
+		t->rows = (sl->scr_h + TILE_SIZE - 1) / TILE_SIZE;
+		t->tile = new SDL_Surface *[t->cols * t->rows];
+		for(int i = 0; i < t->cols * t->rows; i++)
+			t->tile[i] = NULL;
+		sl->tiles = t;
+	}
+	t = sl->tiles;
+	for(int row = src->y / TILE_SIZE; row < t->rows &&
+			row * TILE_SIZE < src->y + src->h; row++)
+	{
+		for(int col = src->x / TILE_SIZE; col < t->cols &&
+				col * TILE_SIZE < src->x + src->w; col++)
+		{
+			tile = t->tile[row * t->cols + col];
+			if(tile == NULL)
+			{
+				tile = make_tile(sl, col, row);
+				t->tile[row * t->cols + col] = tile;
+			}
+			
+			// The part of this tile inside src:
+			tx = col * TILE_SIZE;
+			ty = row * TILE_SIZE;
+			from.x = src->x > tx ? src->x - tx : 0;
+			from.y = src->y > ty ? src->y - ty : 0;
+			x2 = src->x + src->w < tx + tile->w ? src->x + src->w : tx + tile->w;
+			y2 = src->y + src->h < ty + tile->h ? src->y + src->h : ty + tile->h;
+			from.w = x2 - (tx + from.x);
+			from.h = y2 - (ty + from.y);
+			to.x = x + tx + from.x - src->x;
+			to.y = y + ty + from.y - src->y;
+			SDL_BlitSurface(tile, &from, target, &to);
+		}
+	}
+}
+
 void copy_to_screen(slide *sl, int viewx, int viewy)
 {
-	SDL_Rect dst;	
-	dst.x = sl->x - viewx;
-	dst.y = sl->y - viewy;
-	if(sl->scaled == NULL)
-		error("Tried to render a NULL surface in copy_to_screen");
-	int ret = SDL_BlitSurface(sl->scaled, NULL, screen, &dst);
-	if(ret != 0)
-		error("SDL_BlitSurface returned %d\n", ret);
+	SDL_Rect src;
+	int x2, y2;
+
+	if(!slide_in_view(sl))
+		return;
+	if(!tiled_slide(sl))
+		ensure_rendered(sl);
+	
+	// Only the part of the slide which is on screen:
+	src.x = viewx > sl->x ? viewx - sl->x : 0;
+	src.y = viewy > sl->y ? viewy - sl->y : 0;
+	x2 = viewx + SCREEN_WIDTH - sl->x;
+	y2 = viewy + SCREEN_HEIGHT - sl->y;
+	if(x2 > sl->scr_w) x2 = sl->scr_w;
+	if(y2 > sl->scr_h) y2 = sl->scr_h;
+	if(x2 > src.x && y2 > src.y)
+	{
+		src.w = x2 - src.x;
+		src.h = y2 - src.y;
+		copy_scaled(sl, &src, screen, sl->x - viewx + src.x,
+				sl->y - viewy + src.y);
+	}
+	copy_overlay(sl, 0, sl->x - viewx, sl->y - viewy);
+	copy_dragged(sl, 0, sl->x - viewx, sl->y - viewy);
 	if(sl->deck_size > 1)
 		copy_decorations(sl, viewx, viewy);
 	if(sl->selected)
 		highlight(sl, viewx, viewy, 1);
 }
 
-void copy_all_to_screen(slidevector *render_list, int viewx, int viewy)
+void copy_all_to_screen(slide_stack *render_list, int viewx, int viewy)
 {
-	slide *sl;
-	for(int i = 0; i < render_list->count(); i++)
-	{
-		sl = render_list->item(i);
+	// Bottom first, so that the slides on top are drawn last
+	for(slide *sl = render_list->bottom; sl != NULL; sl = sl->above)
 		copy_to_screen(sl, viewx, viewy);
-	}
 }
 
 void mini_copy_to_screen(slide *sl, int viewx, int viewy)
 {
 	SDL_Rect dst;
+	if(!slide_in_view(sl))
+		return;
+	ensure_mini(sl);
 	dst.x = (sl->x - viewx) / 3;
 	dst.y = (sl->y - viewy) / 3;
 	int ret = SDL_BlitSurface(sl->mini, NULL, screen, &dst);
 	if(ret != 0)
 		error("SDL_BlitSurface returned %d\n", ret);
+	copy_overlay(sl, 1, (sl->x - viewx) / 3, (sl->y - viewy) / 3);
+	copy_dragged(sl, 1, (sl->x - viewx) / 3, (sl->y - viewy) / 3);
 	if(sl->deck_size > 1)
 		mini_copy_decorations(sl, viewx, viewy);
 	if(sl->selected)
 		highlight(sl, viewx, viewy, 3);
 }
 
-void mini_copy_all_to_screen(slidevector *render_list, int viewx, int viewy)
+void mini_copy_all_to_screen(slide_stack *render_list, int viewx, int viewy)
 {
-	slide *sl;
-	for(int i = 0; i < render_list->count(); i++)
-	{
-		sl = render_list->item(i);
+	// Bottom first, so that the slides on top are drawn last
+	for(slide *sl = render_list->bottom; sl != NULL; sl = sl->above)
 		mini_copy_to_screen(sl, viewx, viewy);
+}
+
+/* At the micro level the whole talk can be in view at once, far too many
+	slides to blit one by one every frame. Instead they are put together
+	into square tiles of an overview of the canvas at 1/9 scale, and the
+	screen is cut from those. Tiles are kept for the parts of the canvas
+	looked at most recently, and one is put together again only after a
+	slide over it has been redrawn, moved or raised. Whatever is shown
+	over a slide - a lit line, a dragged image, the selection - is left
+	out of the tiles and still drawn every frame. */
+const int OVERVIEW_TILE = 256;
+
+struct overview_tile
+{
+	int col, row;
+	int stale; // A slide over it has changed since it was put together
+	SDL_Surface *surface;
+};
+
+static pvector *overview = NULL; // Most recently used first
+
+int micro_coord(int x)
+{
+	// Rounded down, so the overview has no seam along the axes:
+	return x >= 0 ? x / 9 : -((8 - x) / 9);
+}
+
+int tile_coord(int x)
+{
+	if(x >= 0)
+		return x / OVERVIEW_TILE;
+	return -((OVERVIEW_TILE - 1 - x) / OVERVIEW_TILE);
+}
+
+void overview_bounds(slide *sl, SDL_Rect *r)
+{
+	r->x = micro_coord(sl->x);
+	r->y = micro_coord(sl->y);
+	r->w = sl->micro != NULL ? sl->micro->w : sl->scr_w / 9 + 1;
+	r->h = sl->micro != NULL ? sl->micro->h : sl->scr_h / 9 + 1;
+}
+
+int overlaps_tile(SDL_Rect *r, overview_tile *t)
+{
+	int x = t->col * OVERVIEW_TILE, y = t->row * OVERVIEW_TILE;
+
+	return r->w > 0 && r->h > 0 && r->x < x + OVERVIEW_TILE &&
+			r->y < y + OVERVIEW_TILE && r->x + r->w > x && r->y + r->h > y;
+}
+
+void stale_tiles(SDL_Rect *r)
+{
+	overview_tile *t;
+
+	if(overview == NULL)
+		return;
+	for(int i = 0; i < overview->count(); i++)
+	{
+		t = (overview_tile *)overview->item(i);
+		if(overlaps_tile(r, t))
+			t->stale = 1;
+	}
+}
+
+void damage_overview(slide *sl)
+{
+	/* Called whenever a slide's micro level is redrawn, or it is moved or
+		raised: the tiles under both where it was and where it is now
+		have to be put together again: */
+	SDL_Rect now;
+
+	overview_bounds(sl, &now);
+	stale_tiles(&sl->overview);
+	stale_tiles(&now);
+	sl->overview = now;
+}
+
+void compose_tile(overview_tile *t, slide_stack *render_list)
+{
+	// Bottom first, so that the slides on top are drawn last
+	SDL_Rect r, dst;
+	int ret;
+
+	clear_surface(t->surface, colour->fills->item(canvas_colour));
+	for(slide *sl = render_list->bottom; sl != NULL; sl = sl->above)
+	{
+		overview_bounds(sl, &r);
+		if(!overlaps_tile(&r, t))
+			continue;
+		dst.x = r.x - t->col * OVERVIEW_TILE;
+		dst.y = r.y - t->row * OVERVIEW_TILE;
+		ret = SDL_BlitSurface(sl->micro, NULL, t->surface, &dst);
+		if(ret != 0)
+			error("SDL_BlitSurface returned %d\n", ret);
 	}
+	t->stale = 0;
+}
+
+overview_tile *find_overview_tile(int col, int row)
+{
+	// Enough are kept to cover the screen twice over:
+	int max_tiles = 2 * (SCREEN_WIDTH / OVERVIEW_TILE + 2) *
+			(SCREEN_HEIGHT / OVERVIEW_TILE + 2);
+	overview_tile *t;
+
+	if(overview == NULL)
+		overview = new pvector();
+	for(int i = 0; i < overview->count(); i++)
+	{
+		t = (overview_tile *)overview->item(i);
+		if(t->col == col && t->row == row)
+		{
+			overview->promote(i);
+			return t;
+		}
+	}
+	if(overview->count() >= max_tiles)
+	{
+		// Reuse the least recently used tile:
+		t = (overview_tile *)overview->item(overview->count() - 1);
+		overview->del(overview->count() - 1);
+	}
+	else
+	{
+		t = new overview_tile;
+		t->surface = alloc_surface(OVERVIEW_TILE, OVERVIEW_TILE, MEM_ZOOMED);
+	}
+	t->col = col;
+	t->row = row;
+	t->stale = 1;
+	overview->add(t);
+	overview->promote(overview->count() - 1);
+	return t;
+}
+
+void purge_overview()
+{
+	if(overview == NULL)
+		return;
+	for(int i = 0; i < overview->count(); i++)
+	{
+		overview_tile *t = (overview_tile *)overview->item(i);
+
+		free_surface(t->surface);
+		delete t;
+	}
+	overview->clear();
 }
 
 void micro_copy_to_screen(slide *sl, int viewx, int viewy)
 {
-	SDL_Rect dst;
-	dst.x = (sl->x - viewx) / 9;
-	dst.y = (sl->y - viewy) / 9;
-	int ret = SDL_BlitSurface(sl->micro, NULL, screen, &dst);
-	if(ret != 0)
-		error("SDL_BlitSurface returned %d\n", ret);
+	// What is drawn over the slide, which is already on the overview:
+	int x = micro_coord(sl->x) - micro_coord(viewx);
+	int y = micro_coord(sl->y) - micro_coord(viewy);
+
+	copy_overlay(sl, 2, x, y);
+	copy_dragged(sl, 2, x, y);
 	if(sl->selected)
 		highlight(sl, viewx, viewy, 9);
 }
 
-void micro_copy_all_to_screen(slidevector *render_list, int viewx, int viewy)
+void micro_copy_all_to_screen(slide_stack *render_list, int viewx, int viewy)
 {
-	slide *sl;
-	for(int i = 0; i < render_list->count(); i++)
+	overview_tile *t;
+	SDL_Rect dst;
+	int vx = micro_coord(viewx), vy = micro_coord(viewy);
+
+	for(int row = tile_coord(vy); row * OVERVIEW_TILE < vy + SCREEN_HEIGHT;
+			row++)
 	{
-		sl = render_list->item(i);
+		for(int col = tile_coord(vx); col * OVERVIEW_TILE < vx + SCREEN_WIDTH;
+				col++)
+		{
+			t = find_overview_tile(col, row);
+			if(t->stale)
+				compose_tile(t, render_list);
+			dst.x = col * OVERVIEW_TILE - vx;
+			dst.y = row * OVERVIEW_TILE - vy;
+			SDL_BlitSurface(t->surface, NULL, screen, &dst);
+		}
+	}
+	for(slide *sl = render_list->bottom; sl != NULL; sl = sl->above)
 		micro_copy_to_screen(sl, viewx, viewy);
+}
+
+SDL_Surface *nearest_level(slide *sl, double z)
+{
+	/* The level of the slide's pyramid nearest in scale to z screen
+		coordinates per pixel (half way being the geometric mean), or if
+		the slide hasn't got that one, the next smaller one it has. Nothing
+		is drawn here, as this is called every frame of a zoom; the micro
+		level is always there: */
+	if(z < 1.7320508 && sl->render != NULL) // sqrt(3)
+		return sl->render;
+	if(z < 5.1961524 && sl->mini != NULL) // sqrt(27)
+		return sl->mini;
+	return sl->micro;
+}
+
+void zoom_copy_all_to_screen(slide_stack *render_list, int cx, int cy,
+		double z)
+{
+	/* Draws the canvas at any scale between the zoom levels, with (cx, cy)
+		at the centre of the screen, each slide resampled from the nearest
+		level it already has. Used for the frames of a zoom, so card edges
+		and highlights are left out: */
+	SDL_Rect dst;
+	int x1, y1, x2, y2;
+
+	for(slide *sl = render_list->bottom; sl != NULL; sl = sl->above)
+	{
+		x1 = SCREEN_WIDTH / 2 + (int)floor((sl->x - cx) / z);
+		y1 = SCREEN_HEIGHT / 2 + (int)floor((sl->y - cy) / z);
+		x2 = SCREEN_WIDTH / 2 + (int)floor((sl->x + sl->scr_w - cx) / z);
+		y2 = SCREEN_HEIGHT / 2 + (int)floor((sl->y + sl->scr_h - cy) / z);
+		if(x2 <= 0 || y2 <= 0 || x1 >= SCREEN_WIDTH ||
+				y1 >= SCREEN_HEIGHT || x2 <= x1 || y2 <= y1)
+			continue;
+		dst.x = x1;
+		dst.y = y1;
+		dst.w = x2 - x1;
+		dst.h = y2 - y1;
+		if(scale_blit(nearest_level(sl, z), screen, &dst) != 0)
+			error("scale_blit failed");
 	}
 }
 
@@ -6,6 +6,7 @@ This program is free software; you can redistribute it and/or modify
 it under the terms of the GNU General Public License (version 2) as
 published by the Free Software Foundation. */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
@@ -19,6 +20,7 @@ published by the Free Software Foundation. */
 #include <SDL/SDL_ttf.h>
 #include <SDL/SDL_gfxPrimitives.h>
 #include <SDL/SDL_rotozoom.h>
+#include <jpeglib.h>
 
 #include "datatype.h"
 #include "multitalk.h"
@@ -27,12 +29,13 @@ typedef const char *ConstCharPtr;
 typedef Uint32 *Uint32Ptr;
 
 extern Config *config;
+extern Options *options;
 
 Uint32 surface_flags = SDL_HWSURFACE;
 
 // Prototypes:
 TTF_Font *load_font(const char *font_path, int size);
-SDL_Surface *search_png(const char *dir, const char *filename, int alpha);
+char *search_png(const char *dir, const char *filename);
 SDL_Surface *do_load_png(const char *filename, int alpha);
 int hex_to_byte(const char *hex);
 
@@ -42,52 +45,344 @@ SDL_Surface *load_local_png(const char *filename, int alpha)
 	return do_load_png(filename, alpha);
 }
 
-SDL_Surface *load_png(const char *filename, int alpha)
+char *locate_png(const char *filename)
 {
-	SDL_Surface *img;
+	// Returns the full path of the file that load_png() would read
 	char *t;
 
 	if(filename[0] == '/')
-		return do_load_png(filename, alpha);
+		return sdup(filename);
 	t = expand_tilde(filename);
 	if(t != NULL)
-	{
-		img = do_load_png(t, alpha);
-		delete[] t;
-		return img;
-	}
-	
-	img = search_png(config->project_dir, filename, alpha);	
-	if(img != NULL) return img;
-	img = search_png(config->home_image_dir, filename, alpha);	
-	if(img != NULL) return img;
-	img = search_png(config->env_image_dir, filename, alpha);	
-	if(img != NULL) return img;
-	img = search_png(config->sys_image_dir, filename, alpha);	
-	if(img != NULL) return img;
-	
+		return t;
+
+	t = search_png(config->project_dir, filename);
+	if(t != NULL) return t;
+	t = search_png(config->home_image_dir, filename);
+	if(t != NULL) return t;
+	t = search_png(config->env_image_dir, filename);
+	if(t != NULL) return t;
+	t = search_png(config->sys_image_dir, filename);
+	if(t != NULL) return t;
+
 	error("Cannot locate image <%s>", filename);
 	return NULL;
 }
 
-SDL_Surface *search_png(const char *dir, const char *filename, int alpha)
+SDL_Surface *load_png(const char *filename, int alpha)
 {
-	char *image_file;
 	SDL_Surface *img;
+	char *image_file;
+
+	image_file = locate_png(filename);
+	img = do_load_png(image_file, alpha);
+	delete[] image_file;
+	return img;
+}
+
+char *search_png(const char *dir, const char *filename)
+{
+	char *image_file;
 
 	if(dir == NULL) // Possible if environment variable not set
-		return NULL;	
+		return NULL;
 	image_file = combine_path(dir, filename);
 	if(fexists(image_file))
+		return image_file;
+	delete[] image_file;
+	return NULL;
+}
+
+struct cached_image
+{
+	char *image_file; // Full path, as found by locate_png()
+	time_t mtime;
+	int alpha;
+	int category;
+	SDL_Surface *surface;
+	SDL_Surface *zoomed[ZOOM_LEVELS]; // Resized for each level, on demand
+	pvector *sheets; // Backgrounds made to fit slides, most recent first
+	int refs;
+};
+
+struct image_sheet
+{
+	int tiled; // Repeated at its own size, rather than stretched to fit
+	int level; // Draw level the tile was taken from (tiled only)
+	int w, h;
+	SDL_Surface *surface;
+};
+
+const int MAX_SHEETS = 8; // Per image; a talk seldom has more slide sizes
+const int TEXTURE_SHEET = 512; // Textures are pre-tiled to at least this
+
+static pvector *image_cache = NULL;
+
+SDL_Surface *share_png(const char *filename, int alpha, int category)
+{
+	/* Like load_png(), but the same file is only decoded once however
+		many slides and styles use it. Surfaces from here are shared, so
+		must not be drawn on, and are given back with release_png(). */
+	cached_image *ci;
+	char *image_file;
+	struct stat buf;
+
+	if(image_cache == NULL)
+		image_cache = new pvector();
+	image_file = locate_png(filename);
+	if(stat(image_file, &buf) != 0)
+		error("Unable to load image from %s.", image_file);
+	for(int i = 0; i < image_cache->count(); i++)
 	{
-		img = do_load_png(image_file, alpha);
-		delete[] image_file;
-		return img;
+		ci = (cached_image *)image_cache->item(i);
+		if(ci->alpha == alpha && ci->mtime == buf.st_mtime &&
+				!strcmp(ci->image_file, image_file))
+		{
+			delete[] image_file;
+			ci->refs++;
+			return ci->surface;
+		}
 	}
-	delete[] image_file;
+	ci = new cached_image;
+	ci->image_file = image_file;
+	ci->mtime = buf.st_mtime;
+	ci->alpha = alpha;
+	ci->category = category;
+	ci->surface = do_load_png(image_file, alpha);
+	for(int i = 0; i < ZOOM_LEVELS; i++)
+		ci->zoomed[i] = NULL;
+	ci->sheets = new pvector();
+	ci->refs = 1;
+	track_surface(ci->surface, category);
+	image_cache->add(ci);
+	return ci->surface;
+}
+
+cached_image *find_cached_image(SDL_Surface *surface)
+{
+	cached_image *ci;
+
+	for(int i = 0; i < image_cache->count(); i++)
+	{
+		ci = (cached_image *)image_cache->item(i);
+		if(ci->surface == surface)
+			return ci;
+	}
+	error("Paranoia: image not in cache");
 	return NULL;
 }
 
+void release_png(SDL_Surface *surface)
+{
+	/* Unused images are kept until purge_images(), so that re-reading
+		the talk doesn't have to decode them all again: */
+	if(surface == NULL)
+		return;
+	find_cached_image(surface)->refs--;
+}
+
+SDL_Surface *screen_png(SDL_Surface *surface, int level)
+{
+	/* A shared image resized once from design to screen resolution, and
+		reduced for zoom level 1 or 2, for drawing slides at that size: */
+	cached_image *ci;
+
+	if(scalep == 1 && level == 0)
+		return surface;
+	ci = find_cached_image(surface);
+	if(ci->zoomed[level] == NULL)
+	{
+		ci->zoomed[level] = zoom_surface(ci->surface, (double)scalep /
+				(double)(scaleq * zoom_factor(level)), ci->category);
+	}
+	return ci->zoomed[level];
+}
+
+SDL_Surface *make_sheet(cached_image *ci, int tiled, int level, int w, int h)
+{
+	SDL_Surface *sheet, *src;
+	SDL_Rect dst;
+
+	// Counted with the slides' zoomed levels, as quick to make again:
+	sheet = alloc_surface(w, h, MEM_ZOOMED);
+	if(tiled)
+	{
+		src = (level >= 0) ? screen_png(ci->surface, level) : ci->surface;
+		for(dst.y = 0; dst.y < h; dst.y += src->h)
+		{
+			for(dst.x = 0; dst.x < w; dst.x += src->w)
+				SDL_BlitSurface(src, NULL, sheet, &dst);
+		}
+	}
+	else
+	{
+		src = zoomSurface(ci->surface, (double)w / (double)ci->surface->w,
+				(double)h / (double)ci->surface->h, 1);
+		if(src == NULL)
+			error("zoomSurface returned NULL");
+		SDL_BlitSurface(src, NULL, sheet, NULL);
+		SDL_FreeSurface(src);
+	}
+	return sheet;
+}
+
+SDL_Surface *find_sheet(SDL_Surface *surface, int tiled, int level,
+		int w, int h)
+{
+	cached_image *ci = find_cached_image(surface);
+	image_sheet *is;
+
+	for(int i = 0; i < ci->sheets->count(); i++)
+	{
+		is = (image_sheet *)ci->sheets->item(i);
+		if(is->tiled == tiled && is->level == level && is->w == w &&
+				is->h == h)
+		{
+			ci->sheets->promote(i);
+			return is->surface;
+		}
+	}
+	if(ci->sheets->count() >= MAX_SHEETS)
+	{
+		is = (image_sheet *)ci->sheets->item(ci->sheets->count() - 1);
+		free_surface(is->surface);
+		delete is;
+		ci->sheets->del(ci->sheets->count() - 1);
+	}
+	is = new image_sheet;
+	is->tiled = tiled;
+	is->level = level;
+	is->w = w;
+	is->h = h;
+	is->surface = make_sheet(ci, tiled, level, w, h);
+	ci->sheets->add(is);
+	ci->sheets->promote(ci->sheets->count() - 1);
+	return is->surface;
+}
+
+SDL_Surface *fitted_png(SDL_Surface *surface, int w, int h)
+{
+	/* A shared image stretched to w x h, kept so that redrawing a slide
+		with a background picture doesn't resample the photo every time: */
+	return find_sheet(surface, 0, -1, w, h);
+}
+
+void blit_fitted(SDL_Surface *surface, int w, int h, SDL_Rect *src,
+		SDL_Surface *target, int x, int y)
+{
+	/* Blits the src part of a shared image stretched to w x h, to (x, y)
+		on target. Up to a screenful, the whole stretched image is kept as
+		a sheet; a bigger one (behind a slide drawn a tile at a time) is
+		resampled just under src, with a few pixels either side so that the
+		smoothing matches the pieces next to it: */
+	const int pad = 2;
+	SDL_Surface *part, *zoomed;
+	SDL_Rect from, cut, dst;
+	double fx = (double)w / (double)surface->w;
+	double fy = (double)h / (double)surface->h;
+	int x2, y2;
+
+	dst.x = x;
+	dst.y = y;
+	if((long)w * h <= (long)SCREEN_WIDTH * SCREEN_HEIGHT)
+	{
+		SDL_BlitSurface(fitted_png(surface, w, h), src, target, &dst);
+		return;
+	}
+	from.x = (int)(src->x / fx) - pad;
+	from.y = (int)(src->y / fy) - pad;
+	if(from.x < 0) from.x = 0;
+	if(from.y < 0) from.y = 0;
+	x2 = (int)((src->x + src->w) / fx) + 1 + pad;
+	y2 = (int)((src->y + src->h) / fy) + 1 + pad;
+	if(x2 > surface->w) x2 = surface->w;
+	if(y2 > surface->h) y2 = surface->h;
+	if(x2 <= from.x || y2 <= from.y)
+		return;
+	from.w = x2 - from.x;
+	from.h = y2 - from.y;
+
+	part = alloc_surface(from.w, from.h, MEM_OSD);
+	SDL_BlitSurface(surface, &from, part, NULL);
+	zoomed = zoomSurface(part, fx, fy, 1);
+	if(zoomed == NULL)
+		error("zoomSurface returned NULL");
+	cut.x = src->x - (int)((double)from.x * fx + 0.5);
+	cut.y = src->y - (int)((double)from.y * fy + 0.5);
+	cut.w = src->w;
+	cut.h = src->h;
+	SDL_BlitSurface(zoomed, &cut, target, &dst);
+	SDL_FreeSurface(zoomed);
+	free_surface(part);
+}
+
+SDL_Surface *tiled_png(SDL_Surface *surface, int level)
+{
+	/* A shared image, as reduced for a draw level, repeated across a
+		sheet of whole copies at least TEXTURE_SHEET square. The sheet is
+		blitted across a slide in turn, so its size doesn't depend on the
+		slide's: */
+	SDL_Surface *src = (level >= 0) ? screen_png(surface, level) : surface;
+	int w = src->w * ((TEXTURE_SHEET + src->w - 1) / src->w);
+	int h = src->h * ((TEXTURE_SHEET + src->h - 1) / src->h);
+
+	return find_sheet(surface, 1, level, w, h);
+}
+
+long purge_sheets()
+{
+	/* Drops every background and texture sheet, under the memory budget.
+		Returns the number of bytes freed: */
+	cached_image *ci;
+	image_sheet *is;
+	long bytes = 0;
+
+	for(int i = 0; image_cache != NULL && i < image_cache->count(); i++)
+	{
+		ci = (cached_image *)image_cache->item(i);
+		for(int j = 0; j < ci->sheets->count(); j++)
+		{
+			is = (image_sheet *)ci->sheets->item(j);
+			bytes += surface_bytes(is->surface);
+			free_surface(is->surface);
+			delete is;
+		}
+		ci->sheets->clear();
+	}
+	return bytes;
+}
+
+void purge_images()
+{
+	cached_image *ci;
+
+	if(image_cache == NULL)
+		return;
+	for(int i = image_cache->count() - 1; i >= 0; i--)
+	{
+		ci = (cached_image *)image_cache->item(i);
+		if(ci->refs > 0)
+			continue;
+		free_surface(ci->surface);
+		for(int j = 0; j < ZOOM_LEVELS; j++)
+		{
+			if(ci->zoomed[j] != NULL)
+				free_surface(ci->zoomed[j]);
+		}
+		for(int j = 0; j < ci->sheets->count(); j++)
+		{
+			image_sheet *is = (image_sheet *)ci->sheets->item(j);
+
+			free_surface(is->surface);
+			delete is;
+		}
+		delete ci->sheets;
+		delete[] ci->image_file;
+		delete ci;
+		image_cache->del(i);
+	}
+}
+
 SDL_Surface *do_load_png(const char *filename, int alpha)
 {
 	/* Load an image and convert it to the display's native format,
@@ -111,13 +406,166 @@ SDL_Surface *do_load_png(const char *filename, int alpha)
 	return final;
 }
 
+void jpeg_fatal(j_common_ptr cinfo)
+{
+	char message[JMSG_LENGTH_MAX];
+
+	(*cinfo->err->format_message)(cinfo, message);
+	error("Can't decode JPEG image: %s", message);
+}
+
+SDL_Surface *load_jpeg(const char *filename, int max_w, int max_h,
+		int *natural_w, int *natural_h)
+{
+	/* libjpeg can decode at 1/2, 1/4 or 1/8 scale straight from the DCT
+		coefficients, which is far quicker (and needs far less memory) than
+		decoding a big photo in full only to shrink it. Picks the smallest
+		scale which is still at least as big as the picture will be shown.
+		Returns NULL if the file isn't a JPEG, or is a CMYK one, which
+		libjpeg won't convert to RGB (SDL_image loads those instead). */
+	struct jpeg_decompress_struct cinfo;
+	struct jpeg_error_mgr jerr;
+	unsigned char magic[2];
+	SDL_Surface *surface;
+	JSAMPROW row;
+	FILE *fp;
+	double s;
+	int denom;
+
+	fp = fopen(filename, "rb");
+	if(fp == NULL)
+		error("Unable to load image from %s.", filename);
+	if(fread(magic, 1, 2, fp) != 2 || magic[0] != 0xFF || magic[1] != 0xD8)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	rewind(fp);
+	
+	cinfo.err = jpeg_std_error(&jerr);
+	jerr.error_exit = jpeg_fatal;
+	jpeg_create_decompress(&cinfo);
+	jpeg_stdio_src(&cinfo, fp);
+	jpeg_read_header(&cinfo, TRUE);
+	if(cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK)
+	{
+		jpeg_destroy_decompress(&cinfo);
+		fclose(fp);
+		return NULL;
+	}
+	*natural_w = cinfo.image_width;
+	*natural_h = cinfo.image_height;
+
+	s = (double)max_w / (double)cinfo.image_width;
+	if((double)max_h / (double)cinfo.image_height < s)
+		s = (double)max_h / (double)cinfo.image_height;
+	for(denom = 8; denom > 1 && s * denom > 1.0; denom /= 2)
+		;
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = denom;
+	cinfo.out_color_space = JCS_RGB;
+	jpeg_start_decompress(&cinfo);
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+	surface = SDL_CreateRGBSurface(SDL_SWSURFACE, cinfo.output_width,
+			cinfo.output_height, 24, 0x0000FF, 0x00FF00, 0xFF0000, 0);
+#else
+	surface = SDL_CreateRGBSurface(SDL_SWSURFACE, cinfo.output_width,
+			cinfo.output_height, 24, 0xFF0000, 0x00FF00, 0x0000FF, 0);
+#endif
+	if(surface == NULL)
+		error("Can't allocate surface for %s", filename);
+	SDL_LockSurface(surface);
+	while(cinfo.output_scanline < cinfo.output_height)
+	{
+		row = (JSAMPROW)((Uint8 *)surface->pixels +
+				cinfo.output_scanline * surface->pitch);
+		jpeg_read_scanlines(&cinfo, &row, 1);
+	}
+	SDL_UnlockSurface(surface);
+	
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	fclose(fp);
+	return surface;
+}
+
+SDL_Surface *fit_surface(SDL_Surface *src, int max_w, int max_h)
+{
+	// Returns a smoothly reduced copy no bigger than max_w x max_h
+	SDL_Surface *shrunk, *fitted;
+	double s;
+	int w, h, factor;
+
+	s = (double)max_w / (double)src->w;
+	if((double)max_h / (double)src->h < s)
+		s = (double)max_h / (double)src->h;
+	w = (int)(src->w * s);
+	h = (int)(src->h * s);
+	if(w < 1) w = 1;
+	if(h < 1) h = 1;
+	
+	// Box filter by a whole factor first; zoomSurface only looks at
+	// neighbouring pixels, so on its own it would alias badly:
+	factor = (int)(1.0 / s);
+	if(factor > 1)
+	{
+		shrunk = shrinkSurface(src, factor, factor);
+		if(shrunk == NULL)
+			error("shrinkSurface returned NULL");
+	}
+	else
+		shrunk = src;
+	fitted = zoomSurface(shrunk, (double)w / (double)shrunk->w,
+			(double)h / (double)shrunk->h, SMOOTHING_ON);
+	if(fitted == NULL)
+		error("zoomSurface returned NULL");
+	if(shrunk != src)
+		SDL_FreeSurface(shrunk);
+	return fitted;
+}
+
+SDL_Surface *load_picture(const char *filename, int max_w, int max_h,
+		int *reduced)
+{
+	/* Loads a picture slide's image, reduced to fit within max_w x max_h
+		if it is far bigger; smaller overshoots are left as they are, to be
+		scaled with the rest of the slide. *reduced is set if the file has
+		more detail than the surface returned. */
+	SDL_Surface *img, *fitted;
+	char *image_file;
+	int w, h;
+
+	image_file = locate_png(filename);
+	img = load_jpeg(image_file, max_w, max_h, &w, &h);
+	if(img == NULL)
+	{
+		img = do_load_png(image_file, 0);
+		w = img->w;
+		h = img->h;
+	}
+	delete[] image_file;
+	
+	if(img->w > FAR_BEYOND * max_w || img->h > FAR_BEYOND * max_h)
+	{
+		fitted = fit_surface(img, max_w, max_h);
+		SDL_FreeSurface(img);
+		img = fitted;
+	}
+	*reduced = (w > img->w || h > img->h);
+	return img;
+}
+
 int highest_resolution()
 {
 	SDL_Rect **modes;
+	SDL_PixelFormat format;
 	int max_width = 0;
 
-	// FIXME - Add depth 16 to pixel format
-	modes = SDL_ListModes(NULL, SDL_DOUBLEBUF | SDL_FULLSCREEN | SDL_HWSURFACE);
+	memset(&format, 0, sizeof(SDL_PixelFormat));
+	format.BitsPerPixel = options->depth;
+	modes = SDL_ListModes(&format,
+			SDL_DOUBLEBUF | SDL_FULLSCREEN | SDL_HWSURFACE);
 
 	if(modes == NULL)
 		error("No video modes available.");
@@ -144,6 +592,9 @@ void init_sdl(const char *caption, int offscreen)
 
 	SDL_WM_SetCaption(caption, caption);
 
+	if(options->depth != 16 && options->depth != 24 && options->depth != 32)
+		error("Unsupported display depth %d (use 16, 24 or 32)", options->depth);
+	
 	if(fullscreen == -1)
 	{
 		// Autodetect:
@@ -156,17 +607,17 @@ void init_sdl(const char *caption, int offscreen)
 	if(offscreen)
 	{
 		screen = SDL_SetVideoMode(1, 1,
-			16, SDL_DOUBLEBUF | surface_flags);
+			options->depth, SDL_DOUBLEBUF | surface_flags);
 	}
 	else if(fullscreen)
 	{
 		screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT,
-			16, SDL_DOUBLEBUF | surface_flags | SDL_FULLSCREEN);
+			options->depth, SDL_DOUBLEBUF | surface_flags | SDL_FULLSCREEN);
 	}
 	else
 	{
 		screen = SDL_SetVideoMode(SCREEN_WIDTH, SCREEN_HEIGHT,
-			16, SDL_DOUBLEBUF | surface_flags);
+			options->depth, SDL_DOUBLEBUF | surface_flags);
 	}
 	
 	if(screen == NULL)
@@ -206,7 +657,7 @@ TTF_Font *try_font(const char *dir, const char *file, int size)
 	return font;
 }
 
-TTF_Font *init_font(Config *config, const char *font_file, int size)
+TTF_Font *locate_font(Config *config, const char *font_file, int size)
 {
 	TTF_Font *font;
 
@@ -226,6 +677,108 @@ TTF_Font *init_font(Config *config, const char *font_file, int size)
 	return NULL;
 }
 
+struct cached_font
+{
+	char *font_file;
+	int size;
+	TTF_Font *font;
+	TTF_Font *zoomed[ZOOM_LEVELS]; // Scaled for each zoom level, on demand
+	int refs;
+};
+
+static pvector *font_cache = NULL;
+
+cached_font *find_cached_font(TTF_Font *font)
+{
+	cached_font *cf;
+	
+	for(int i = 0; i < font_cache->count(); i++)
+	{
+		cf = (cached_font *)font_cache->item(i);
+		if(cf->font == font)
+			return cf;
+	}
+	error("Paranoia: font not in cache");
+	return NULL;
+}
+
+TTF_Font *init_font(Config *config, const char *font_file, int size)
+{
+	/* Fonts are shared between styles, so each call takes out a reference
+		which must be given back with release_font(): */
+	cached_font *cf;
+
+	if(font_cache == NULL)
+		font_cache = new pvector();
+	for(int i = 0; i < font_cache->count(); i++)
+	{
+		cf = (cached_font *)font_cache->item(i);
+		if(cf->size == size && !strcmp(cf->font_file, font_file))
+		{
+			cf->refs++;
+			return cf->font;
+		}
+	}
+	cf = new cached_font;
+	cf->font_file = sdup(font_file);
+	cf->size = size;
+	cf->font = locate_font(config, font_file, size);
+	for(int i = 0; i < ZOOM_LEVELS; i++)
+		cf->zoomed[i] = NULL;
+	cf->refs = 1;
+	font_cache->add(cf);
+	return cf->font;
+}
+
+void retain_font(TTF_Font *font)
+{
+	find_cached_font(font)->refs++;
+}
+
+void release_font(TTF_Font *font)
+{
+	cached_font *cf;
+	
+	if(font == NULL)
+		return;
+	cf = find_cached_font(font);
+	cf->refs--;
+	if(cf->refs > 0)
+		return;
+	for(int i = 0; i < ZOOM_LEVELS; i++)
+	{
+		if(cf->zoomed[i] != NULL && cf->zoomed[i] != cf->font)
+			release_font(cf->zoomed[i]);
+	}
+	forget_glyphs(cf->font);
+	TTF_CloseFont(cf->font);
+	font_cache->del(font_cache->find(cf));
+	delete[] cf->font_file;
+	delete cf;
+}
+
+TTF_Font *screen_font(TTF_Font *font, int level)
+{
+	/* The design size font scaled up or down to the display, and reduced
+		for zoom level 1 or 2, for drawing slides straight at that size.
+		It holds a reference until the design size font itself is released.
+		Returns NULL if the text would be too small to be legible: */
+	cached_font *cf = find_cached_font(font);
+	int size;
+
+	size = to_screen_coords(cf->size) / zoom_factor(level);
+	if(size < MIN_FONT_SIZE)
+		return NULL;
+	if(cf->zoomed[level] == NULL)
+	{
+		if(size == cf->size)
+			cf->zoomed[level] = cf->font;
+		else
+			cf->zoomed[level] = init_font(config, cf->font_file, size);
+	}
+	return cf->zoomed[level];
+}
+
 /*		
 TTF_Font *init_font(const char *resource_path, const char *font_file, int size)
 {
@@ -401,24 +954,11 @@ int hex_to_byte(const char *hex)
 int render_text(const char *s, TTF_Font *font, int colour_index,
 		SDL_Surface *surface, int x, int y, int underlined)
 {
-	SDL_Rect dst;
-	SDL_Surface *text;
 	int new_pos;
-	SDL_Color *col = colour->inks->item(colour_index);
 	Uint32 pen = colour->pens->item(colour_index);
 
-	text = TTF_RenderUTF8_Blended(font, s, *col);
-	if(text == NULL)
-		error("Couldn't render text: %s\n", SDL_GetError());
-	dst.x = x;
-	dst.y = y;
-	// dst.w = text->w;
-	// dst.h = text->h;
-	int ret = SDL_BlitSurface(text, NULL, surface, &dst);
-	if(ret != 0)
-		error("SDL_BlitSurface return %d in render_text (%d, %d)\n", ret, x, y);
-	new_pos = text->w + x;
-	SDL_FreeSurface(text);
+	new_pos = draw_text(s, font, colour->inks->item(colour_index), surface,
+			x, y);
 	// If non-zero, request a line drawn "underlined" pixels below:
 	if(underlined > 0)
 	{
@@ -431,45 +971,26 @@ int render_text(const char *s, TTF_Font *font, int colour_index,
 int render_text(const char *s, TTF_Font *font, SDL_Color *col,
 		SDL_Surface *surface, int x, int y)
 {
-	SDL_Rect dst;
-	SDL_Surface *text;
-	int new_pos;
-
-	text = TTF_RenderUTF8_Blended(font, s, *col);
-	if(text == NULL)
-		error("Couldn't render text: %s\n", SDL_GetError());
-	dst.x = x;
-	dst.y = y;
-	// dst.w = text->w;
-	// dst.h = text->h;
-	int ret = SDL_BlitSurface(text, NULL, surface, &dst);
-	if(ret != 0)
-		error("SDL_BlitSurface return %d in render_text (%d, %d)\n", ret, x, y);
-	new_pos = text->w + x;
-	SDL_FreeSurface(text);
-	return new_pos;
+	return draw_text(s, font, col, surface, x, y);
 }
 
-SDL_Surface *alloc_surface(int w, int h)
+SDL_Surface *alloc_surface(int w, int h, int category, slide *owner)
 {
-	SDL_Surface *temp_surface, *final_surface;
-	Uint32 rmask, gmask, bmask, amask;
+	/* Create the surface directly in the display's pixel format (normally
+		32-bit XRGB), so there is no intermediate surface to convert and
+		blits to the screen, and from TTF output and loaded images, use
+		SDL's same-format paths: */
 	
-	rmask = 0x000000FF;
-	gmask = 0x0000FF00;
-	bmask = 0x00FF0000;
-	amask = 0xFF000000;
-	temp_surface = SDL_CreateRGBSurface(surface_flags, w, h, 24,
-			rmask, gmask, bmask, amask);
-	if(temp_surface == NULL)
-		error("SDL_CreateRGBSurface failed on (%d, %d)\n", w, h);
+	SDL_PixelFormat *fmt = screen->format;
+	SDL_Surface *surface;
 	
-	final_surface = SDL_DisplayFormat(temp_surface);
-	if(final_surface == NULL)
-		error("SDL_DisplayFormat failed on (%d, %d)\n", w, h);
-	SDL_FreeSurface(temp_surface);
+	surface = SDL_CreateRGBSurface(surface_flags, w, h, fmt->BitsPerPixel,
+			fmt->Rmask, fmt->Gmask, fmt->Bmask, 0);
+	if(surface == NULL)
+		error("SDL_CreateRGBSurface failed on (%d, %d)\n", w, h);
+	track_surface(surface, category, owner);
 	
-	return final_surface;
+	return surface;
 }
 
 void clear_surface(SDL_Surface *surface, Uint32 co)
@@ -482,3 +1003,149 @@ void clear_surface(SDL_Surface *surface, Uint32 co)
 	SDL_FillRect(surface, &dst, co);	
 }
 
+/* Run-length encoding of surfaces, for keeping slides which are out of view
+	in less memory. Rendered slides are mostly flat colour, so this typically
+	compresses them by well over 10:1 and expands them again far faster than
+	re-rendering the text. Each row is a sequence of packets with a one byte
+	header: 0-127 means a literal of 1-128 pixels follows; 128-255 means
+	the single pixel which follows is repeated 2-129 times. */
+
+static const int RLE_MAX_LITERAL = 128;
+static const int RLE_MAX_RUN = 129;
+
+inline int same_pixel(Uint8 *a, Uint8 *b, int bpp)
+{
+	if(bpp == 4)
+		return *(Uint32 *)a == *(Uint32 *)b;
+	return memcmp(a, b, bpp) == 0;
+}
+
+packed_surface *pack_surface(SDL_Surface *surface)
+{
+	packed_surface *packed;
+	Uint8 *buf, *out, *row;
+	int bpp = surface->format->BytesPerPixel;
+	int w = surface->w;
+	int i, run, start;
+
+	packed = new packed_surface;
+	packed->w = w;
+	packed->h = surface->h;
+	packed->depth = surface->format->BitsPerPixel;
+	packed->flags = surface->flags & SDL_HWSURFACE;
+	packed->rmask = surface->format->Rmask;
+	packed->gmask = surface->format->Gmask;
+	packed->bmask = surface->format->Bmask;
+	packed->amask = surface->format->Amask;
+	
+	// Worst case is one header byte per pixel:
+	buf = new Uint8[(long)w * (bpp + 1) * surface->h];
+	out = buf;
+	if(SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+	for(int y = 0; y < surface->h; y++)
+	{
+		row = (Uint8 *)surface->pixels + y * surface->pitch;
+		i = 0;
+		while(i < w)
+		{
+			run = 1;
+			while(i + run < w && run < RLE_MAX_RUN &&
+					same_pixel(row + (i + run) * bpp, row + i * bpp, bpp))
+				run++;
+			if(run >= 2)
+			{
+				*out++ = (Uint8)(128 + run - 2);
+				memcpy(out, row + i * bpp, bpp);
+				out += bpp;
+				i += run;
+				continue;
+			}
+			// Literal, up to the start of the next run:
+			start = i;
+			while(i < w && i - start < RLE_MAX_LITERAL)
+			{
+				if(i + 1 < w && same_pixel(row + (i + 1) * bpp, row + i * bpp, bpp))
+					break;
+				i++;
+			}
+			*out++ = (Uint8)(i - start - 1);
+			memcpy(out, row + start * bpp, (i - start) * bpp);
+			out += (i - start) * bpp;
+		}
+	}
+	if(SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+	
+	packed->bytes = out - buf;
+	packed->data = new Uint8[packed->bytes];
+	memcpy(packed->data, buf, packed->bytes);
+	delete[] buf;
+	
+	return packed;
+}
+
+SDL_Surface *unpack_surface(packed_surface *packed)
+{
+	SDL_Surface *surface;
+	Uint8 *in, *row, *end;
+	int bpp, n;
+
+	surface = SDL_CreateRGBSurface(packed->flags, packed->w, packed->h,
+			packed->depth, packed->rmask, packed->gmask, packed->bmask,
+			packed->amask);
+	if(surface == NULL)
+		error("SDL_CreateRGBSurface failed on (%d, %d)\n", packed->w, packed->h);
+	bpp = surface->format->BytesPerPixel;
+	
+	in = packed->data;
+	if(SDL_MUSTLOCK(surface))
+		SDL_LockSurface(surface);
+	for(int y = 0; y < packed->h; y++)
+	{
+		row = (Uint8 *)surface->pixels + y * surface->pitch;
+		end = row + packed->w * bpp;
+		while(row < end)
+		{
+			if(*in < 128)
+			{
+				n = (*in++ + 1) * bpp;
+				memcpy(row, in, n);
+				in += n;
+				row += n;
+			}
+			else
+			{
+				n = *in++ - 128 + 2;
+				if(bpp == 4)
+				{
+					Uint32 pixel, *p = (Uint32 *)row;
+					
+					memcpy(&pixel, in, 4); // Packed data may be unaligned
+					
+					for(int i = 0; i < n; i++)
+						p[i] = pixel;
+				}
+				else
+				{
+					for(int i = 0; i < n; i++)
+						memcpy(row + i * bpp, in, bpp);
+				}
+				in += bpp;
+				row += n * bpp;
+			}
+		}
+	}
+	if(SDL_MUSTLOCK(surface))
+		SDL_UnlockSurface(surface);
+	
+	return surface;
+}
+
+void free_packed_surface(packed_surface *packed)
+{
+	if(packed == NULL)
+		return;
+	delete[] packed->data;
+	delete packed;
+}
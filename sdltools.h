@@ -17,6 +17,7 @@ struct logo;
 struct Config
 {
 	char *talk_path, *graph_path, *project_dir, *latex_dir, *html_dir;
+	char *memory_path;
 	char *sys_dir, *sys_style_dir, *sys_font_dir, *sys_image_dir;
 	char *env_dir, *env_style_dir, *env_font_dir, *env_image_dir;
 	char *proj_style_dir, *proj_font_dir;
@@ -33,6 +34,14 @@ class Options
 	const char *dvipscmd;
 	const char *convertcmd;
 	int warpsteps;
+	int depth; // Bits per pixel of the display and all slide surfaces
+	int memorybudget; // Megabytes of slide bitmaps to keep, 0 for no limit
+	int compress; // Compress evicted slides rather than discarding them
+	int directrender; // Draw slides at screen resolution, not design size
+	int directzoom; // Draw the mini and micro levels, not reduce them
+	int zoomtime; // Milliseconds to zoom between levels, 0 to jump
+	int warptime; // Milliseconds a warp to another slide takes, 0 to jump
+	int presentthread; // Put frames on the display from a thread of their own
 	
 	Options();
 	void update(dictionary *d);
@@ -67,15 +76,69 @@ class node
 	subimagevector *local_images;
 };
 
+enum MemoryCategory { MEM_SLIDES, MEM_ZOOMED, MEM_DECORATIONS, MEM_LATEX,
+		MEM_STYLES, MEM_SUBIMAGES, MEM_PACKED, MEM_OSD, MEM_CATEGORIES };
+
 struct decorations
 {
 	SDL_Surface *top, *bottom, *left, *right;
 };
 
+struct card_look // Everything the edges of the cards in a deck depend on
+{
+	int edge, border; // Width of each card's edge, and of its border lines
+	int bar_h, rule_y, rule_h; // Titlebar, and the line beneath it
+	Uint32 border_fill, bar_fill, body_fill, seen_fill;
+};
+
+const int CARD_STRIP = 256; // Length of the repeated part of a card edge
+
+struct card_sprites
+{
+	card_look look;
+	SDL_Surface *behind_band, *behind_column; // Cards still to come
+	SDL_Surface *seen_band, *seen_column; // Cards already shown
+};
+
+const int TILE_SIZE = 256; // Screen resolution slide tiles are this square
+const int FAR_BEYOND = 2; // Pictures are only reduced this many times too big
+const int ZOOM_LEVELS = 3; // Full size, mini and micro
+const int MIN_FONT_SIZE = 6; // Smaller text is drawn as greeked bars
+
+struct slide_tiles
+{
+	/* The screen resolution copy of a slide, cut into tiles which are
+		only scaled from the render surface once they come into view, or
+		for a slide too big for one (see tiled_slide()) drawn then: */
+	int cols, rows;
+	SDL_Surface **tile; // cols * rows, row by row, NULL until needed
+};
+
+struct packed_surface
+{
+	int w, h, depth;
+	Uint32 flags, rmask, gmask, bmask, amask; // To recreate the same format
+	long bytes; // Size of the run-length encoded data
+	Uint8 *data;
+};
+
+struct packed_level
+{
+	/* Compressed copy of a slide's full resolution bitmaps, kept instead
+		of the surfaces themselves when the slide is far from the view: */
+	packed_surface *render;
+	packed_surface *top, *bottom, *left, *right; // Card stack decorations
+	long raw_bytes; // Total size before compression
+};
+
+struct atlas_cell; // Private to atlas.cpp
+
 struct slide
 {
 	int deck_size, card;
-	SDL_Surface *render, *scaled, *mini, *micro;
+	SDL_Surface *render, *mini, *micro;
+	atlas_cell *micro_cell; // Where micro's pixels are, in the atlas
+	slide_tiles *tiles; // Screen resolution tiles, unless render is already
 	decorations decor, mini_decor;
 	int x, y; // Position in screen coords
 	int scr_w, scr_h, des_w, des_h; // Dimensions in screen and design coords
@@ -88,6 +151,18 @@ struct slide
 	subimagevector *embedded_images;
 	subimagevector *visible_images;
 	int selected;
+	packed_level *packed; // NULL unless the full size bitmaps are compressed
+	int reduced; // Picture slides only: image shrunk to fit the design size
+	long memory[MEM_CATEGORIES]; // Bytes used by this slide in each category
+	slide *above, *below; // Neighbours in the stacking order
+	SDL_Rect overview; // Where it was last put on the micro level overview
+};
+
+struct slide_stack
+{
+	/* The order slides are drawn in, bottom first, as a list threaded
+		through the slides themselves so any slide can be raised at once: */
+	slide *bottom, *top;
 };
 
 struct subimage
@@ -129,6 +204,7 @@ class displayline
 	int highlighted;
 	DrawMode initial_dm;
 	SDL_Surface *import; // For "image lines" (e.g. Latex), alternative to line
+	SDL_Surface *scaled_import[ZOOM_LEVELS]; // Resized for each level, on demand
 	int rule;   // Flag indicating a rule, alternative to line
 	char *line; // Actual text, after the folding handle (NULL if import used)
 	// Note, text may still include these special chars: { $, *, /, \, % }
@@ -330,14 +406,75 @@ typedef const char *constCharPtr;
 void init_sdl(const char *caption, int offscreen);
 SDL_Surface *load_png(const char *filename, int alpha);
 SDL_Surface *load_local_png(const char *filename, int alpha);
+SDL_Surface *share_png(const char *filename, int alpha, int category);
+SDL_Surface *load_picture(const char *filename, int max_w, int max_h,
+		int *reduced);
+SDL_Surface *fit_surface(SDL_Surface *src, int max_w, int max_h);
+void release_png(SDL_Surface *surface);
+SDL_Surface *screen_png(SDL_Surface *surface, int level = 0);
+SDL_Surface *fitted_png(SDL_Surface *surface, int w, int h);
+void blit_fitted(SDL_Surface *surface, int w, int h, SDL_Rect *src,
+		SDL_Surface *target, int x, int y);
+SDL_Surface *tiled_png(SDL_Surface *surface, int level);
+long purge_sheets();
+void purge_images();
 void init_colours();
 TTF_Font *init_font(Config *config, const char *font_file, int size);
+void retain_font(TTF_Font *font);
+void release_font(TTF_Font *font);
+TTF_Font *screen_font(TTF_Font *font, int level = 0);
 int render_text(const char *s, TTF_Font *font, SDL_Color *color,
 		SDL_Surface *surface, int x, int y);
 int render_text(const char *s, TTF_Font *font, int colour_index,
 		SDL_Surface *surface, int x, int y, int underlined);
-SDL_Surface *alloc_surface(int w, int h);
+SDL_Surface *alloc_surface(int w, int h, int category = MEM_OSD,
+		slide *owner = NULL);
 void clear_surface(SDL_Surface *surface, Uint32 co);
+packed_surface *pack_surface(SDL_Surface *surface);
+SDL_Surface *unpack_surface(packed_surface *packed);
+void free_packed_surface(packed_surface *packed);
+
+// Text drawing from cached glyphs, from glyphs.cpp:
+int measure_text(TTF_Font *font, const char *s, int *w, int *h);
+int draw_text(const char *s, TTF_Font *font, SDL_Color *col,
+		SDL_Surface *surface, int x, int y);
+void forget_glyphs(TTF_Font *font);
+
+// Pre-drawn bullets, fold icons and card edges, from sprites.cpp:
+SDL_Surface *bullet_sprite(int rx, int ry, int oval, Uint32 pen);
+SDL_Surface *fold_sprite(int level, Uint32 pen);
+card_sprites *find_card_sprites(card_look *look);
+int card_head(card_look *look);
+void tile_sprite(SDL_Surface *sprite, int sx, int sy, int sw, int sh,
+		SDL_Surface *target, int x, int y, int w, int h);
+void purge_sprites();
+
+// Alpha blending and resampling, from blit.cpp:
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define SSE2_KERNELS // Built alongside the C kernels; include <emmintrin.h>
+#define SSE2_TARGET __attribute__((target("sse2")))
+#endif
+int have_sse2();
+int blend_blit(SDL_Surface *src, SDL_Rect *srcrect, SDL_Surface *dst,
+		SDL_Rect *dstrect);
+int scale_blit(SDL_Surface *src, SDL_Surface *dst, SDL_Rect *dstrect);
+
+// Showing frames, from present.cpp:
+void start_presenter();
+void present();
+void toggle_fullscreen();
+int poll_event(SDL_Event *event);
+void wait_event(SDL_Event *event);
+int show_cursor(int toggle);
+void iconify_window();
+SDL_GrabMode grab_input(SDL_GrabMode mode);
+
+// Surface accounting, from memory.cpp:
+long surface_bytes(SDL_Surface *surface);
+void track_surface(SDL_Surface *surface, int category, slide *owner = NULL);
+void free_surface(SDL_Surface *surface);
+SDL_Surface *zoom_surface(SDL_Surface *src, double f, int category,
+		slide *owner = NULL);
 
 void error(const char *format, ...);
 
@@ -0,0 +1,263 @@
+/* sprites.cpp - DMI - 19-10-2026
+
+Copyright (C) 2006-8 David Ingram
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License (version 2) as
+published by the Free Software Foundation. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL/SDL.h>
+#include <SDL/SDL_image.h>
+#include <SDL/SDL_ttf.h>
+#include <SDL/SDL_gfxPrimitives.h>
+#include <SDL/SDL_rotozoom.h>
+
+#include "datatype.h"
+#include "multitalk.h"
+
+/* The parts of a slide drawn by the style rather than the talk - plain
+	bullets, fold icons and the edges of the cards in a deck - are drawn
+	once for each size and colour they are needed in, and then just
+	blitted. They are cached by appearance rather than by style, so that
+	styles which look the same share them, and reloading the talk doesn't
+	leave any behind that refer to freed styles. Card edges are kept as a
+	few short pieces, repeated along the edges of cards of any size. */
+
+enum SpriteKind { SPRITE_CIRCLE, SPRITE_OVAL, SPRITE_FOLD };
+
+struct sprite
+{
+	int kind;
+	int w, h; // Size for bullets; draw level for fold icons
+	Uint32 pen;
+	SDL_Surface *surface;
+};
+
+static pvector *sprites = NULL;
+static pvector *card_sets = NULL;
+
+SDL_Surface *alloc_sprite(int w, int h)
+{
+	// Transparent, to be drawn on and then blended with blend_blit():
+	SDL_Surface *surface;
+
+	surface = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA, w, h, 32,
+			0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+	if(surface == NULL)
+		error("SDL_CreateRGBSurface failed on sprite (%d, %d)\n", w, h);
+	SDL_FillRect(surface, NULL, 0);
+	track_surface(surface, MEM_STYLES);
+	return surface;
+}
+
+sprite *find_sprite(int kind, int w, int h, Uint32 pen)
+{
+	sprite *sp;
+
+	if(sprites == NULL)
+		sprites = new pvector();
+	for(int i = 0; i < sprites->count(); i++)
+	{
+		sp = (sprite *)sprites->item(i);
+		if(sp->kind == kind && sp->w == w && sp->h == h && sp->pen == pen)
+			return sp;
+	}
+	sp = new sprite;
+	sp->kind = kind;
+	sp->w = w;
+	sp->h = h;
+	sp->pen = pen;
+	sp->surface = NULL;
+	sprites->add(sp);
+	return sp;
+}
+
+SDL_Surface *bullet_sprite(int rx, int ry, int oval, Uint32 pen)
+{
+	/* A plain bullet with a light grey rim, radii in pixels, centred in
+		a (2 * rx + 1) x (2 * ry + 1) sprite: */
+	sprite *sp = find_sprite(oval ? SPRITE_OVAL : SPRITE_CIRCLE, rx, ry, pen);
+
+	if(sp->surface != NULL)
+		return sp->surface;
+	sp->surface = alloc_sprite(2 * rx + 1, 2 * ry + 1);
+	if(oval)
+	{
+		filledEllipseColor(sp->surface, rx, ry, rx, ry,
+				colour->light_grey_pen);
+		filledEllipseColor(sp->surface, rx, ry, rx - 1, ry - 1, pen);
+	}
+	else
+	{
+		filledCircleColor(sp->surface, rx, ry, rx, colour->light_grey_pen);
+		filledCircleColor(sp->surface, rx, ry, rx - 1, pen);
+	}
+	return sp->surface;
+}
+
+SDL_Surface *fold_sprite(int level, Uint32 pen)
+{
+	/* The fold icon used when the style has no picture for it, at the
+		current draw level; its top left is the icon's (x, y - 10): */
+	sprite *sp = find_sprite(SPRITE_FOLD, level, 0, pen);
+	Sint16 x2, x3, x4, x5, y2, y3, y5;
+
+	if(sp->surface != NULL)
+		return sp->surface;
+	x2 = to_draw_coords(3);
+	x3 = to_draw_coords(10);
+	x4 = to_draw_coords(17);
+	x5 = to_draw_coords(20);
+	y2 = to_draw_coords(4);
+	y3 = to_draw_coords(16);
+	y5 = to_draw_coords(20);
+	sp->surface = alloc_sprite(x5 + 1, y5 + 1);
+	boxColor(sp->surface, 0, 0, x5, y5, pen);
+	rectangleColor(sp->surface, 0, 0, x5, y5, colour->black_pen);
+	filledTrigonColor(sp->surface, x2, y2, x4, y2, x3, y3, colour->white_pen);
+	aatrigonColor(sp->surface, x2, y2, x4, y2, x3, y3, colour->black_pen);
+	return sp->surface;
+}
+
+void fill_area(SDL_Surface *surface, int x, int y, int w, int h, Uint32 fill)
+{
+	SDL_Rect dst;
+
+	if(w <= 0 || h <= 0)
+		return;
+	dst.x = x;
+	dst.y = y;
+	dst.w = w;
+	dst.h = h;
+	SDL_FillRect(surface, &dst, fill);
+}
+
+int card_head(card_look *look)
+{
+	// Rows at the top of a card's right edge which differ from the rest
+	int head = look->border;
+
+	if(look->bar_h > head)
+		head = look->bar_h;
+	if(look->rule_y + look->rule_h > head)
+		head = look->rule_y + look->rule_h;
+	return head;
+}
+
+void make_card_sprites(card_sprites *cs)
+{
+	card_look *look = &cs->look;
+	int e = look->edge, b = look->border;
+	int head = card_head(look);
+	SDL_Surface *s;
+
+	/* The top edge of a card behind the slide: a corner, then the part
+		repeated along the edge. Card edges are opaque, so are kept in the
+		display format like the slides themselves: */
+	s = alloc_surface(b + CARD_STRIP, e, MEM_STYLES);
+	fill_area(s, 0, 0, s->w, e, look->bar_fill);
+	fill_area(s, 0, 0, b, e, look->border_fill);
+	fill_area(s, 0, 0, s->w, b, look->border_fill);
+	cs->behind_band = s;
+
+	// Its right edge: the end of the titlebar, the body, and the foot:
+	s = alloc_surface(e, head + CARD_STRIP + b, MEM_STYLES);
+	fill_area(s, 0, 0, e, s->h, look->body_fill);
+	fill_area(s, 0, b, e - b, look->bar_h - b, look->bar_fill);
+	fill_area(s, 0, look->rule_y, e, look->rule_h, look->border_fill);
+	fill_area(s, e - b, 0, b, s->h, look->border_fill);
+	fill_area(s, 0, 0, e, b, look->border_fill);
+	fill_area(s, 0, s->h - b, e, b, look->border_fill);
+	cs->behind_column = s;
+
+	// The bottom edge of a card already seen, ending in a corner:
+	s = alloc_surface(CARD_STRIP + b, e, MEM_STYLES);
+	fill_area(s, 0, 0, s->w, e, look->seen_fill);
+	fill_area(s, 0, e - b, s->w, b, look->border_fill);
+	fill_area(s, CARD_STRIP, 0, b, e, look->border_fill);
+	cs->seen_band = s;
+
+	// Its left edge: the top, the body, and the bottom left corner:
+	s = alloc_surface(e, b + CARD_STRIP + e, MEM_STYLES);
+	fill_area(s, 0, 0, e, s->h, look->seen_fill);
+	fill_area(s, 0, 0, b, s->h, look->border_fill);
+	fill_area(s, 0, 0, e, b, look->border_fill);
+	fill_area(s, 0, s->h - b, e, b, look->border_fill);
+	cs->seen_column = s;
+}
+
+card_sprites *find_card_sprites(card_look *look)
+{
+	card_sprites *cs;
+
+	if(card_sets == NULL)
+		card_sets = new pvector();
+	for(int i = 0; i < card_sets->count(); i++)
+	{
+		cs = (card_sprites *)card_sets->item(i);
+		if(!memcmp(&cs->look, look, sizeof(card_look)))
+			return cs;
+	}
+	cs = new card_sprites;
+	cs->look = *look;
+	make_card_sprites(cs);
+	card_sets->add(cs);
+	return cs;
+}
+
+void tile_sprite(SDL_Surface *sprite, int sx, int sy, int sw, int sh,
+		SDL_Surface *target, int x, int y, int w, int h)
+{
+	// Repeats part of a sprite across an area, cutting off the last ones:
+	SDL_Rect src, dst;
+
+	if(sw <= 0 || sh <= 0)
+		return;
+	for(int dy = 0; dy < h; dy += sh)
+	{
+		for(int dx = 0; dx < w; dx += sw)
+		{
+			src.x = sx;
+			src.y = sy;
+			src.w = (w - dx < sw) ? w - dx : sw;
+			src.h = (h - dy < sh) ? h - dy : sh;
+			dst.x = x + dx;
+			dst.y = y + dy;
+			SDL_BlitSurface(sprite, &src, target, &dst);
+		}
+	}
+}
+
+void purge_sprites()
+{
+	// Called when the talk is reloaded, as the colours may have changed
+	if(sprites != NULL)
+	{
+		for(int i = 0; i < sprites->count(); i++)
+		{
+			sprite *sp = (sprite *)sprites->item(i);
+
+			free_surface(sp->surface);
+			delete sp;
+		}
+		sprites->clear();
+	}
+	if(card_sets != NULL)
+	{
+		for(int i = 0; i < card_sets->count(); i++)
+		{
+			card_sprites *cs = (card_sprites *)card_sets->item(i);
+
+			free_surface(cs->behind_band);
+			free_surface(cs->behind_column);
+			free_surface(cs->seen_band);
+			free_surface(cs->seen_column);
+			delete cs;
+		}
+		card_sets->clear();
+	}
+}
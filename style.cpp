@@ -236,6 +236,13 @@ stylevector *load_styles(Config *config)
 	return style_list;
 }
 
+void free_styles(stylevector *style_list)
+{
+	for(int i = 0; i < style_list->count(); i++)
+		delete style_list->item(i);
+	delete style_list;
+}
+
 int get_colour_index(const char *name)
 {
 	int colour_index;
@@ -373,10 +380,15 @@ void set_surface_property(dictionary *d, const char *name, constCharPtr *dest,
 	value = d->lookup_ignore_case(name);
 	if(value != NULL)
 	{
+		if(*dest != NULL)
+			delete[] (*dest);
+		if(*surface != NULL)
+			release_png(*surface);
+		
 		buf = new char[strlen(value) + 1];
 		strcpy(buf, value);
 		*dest = buf;
-		*surface = load_png(value, alpha);
+		*surface = share_png(value, alpha, MEM_STYLES);
 	}
 }
 
@@ -398,16 +410,19 @@ void set_font_property(dictionary *d, const char *name, constCharPtr *dest,
 {
 	const char *value;
 	char *buf;
+	TTF_Font *old_font;
 	
 	value = d->lookup_ignore_case(name);
 	if(value != NULL)
 	{
 		buf = new char[strlen(value) + 1];
 		strcpy(buf, value);
+		delete[] (*dest);
 		*dest = buf;
-		/* Note: would be nice to deallocate old font here, but not always
-			safe to do so if this is an inherited style and font ptr is shared */
+		// Fonts are reference counted, so inherited ones can be released:
+		old_font = *font;
 		*font = init_font(config, value, size);
+		release_font(old_font);
 	}
 }
 
@@ -416,15 +431,16 @@ void set_ptsize_property(dictionary *d, const char *name, int *dest,
 {
 	const char *value;
 	int data;
+	TTF_Font *old_font;
 	
 	value = d->lookup_ignore_case(name);
 	if(value != NULL)
 	{
 		data = atoi(value);
 		*dest = data;
-		/* Note: would be nice to deallocate old font here, but not always
-			safe to do so if this is an inherited style and font ptr is shared */
+		old_font = *font;
 		*font = init_font(config, fontname, data);
+		release_font(old_font);
 	}
 }
 
@@ -447,12 +463,18 @@ void style::init_fonts(style *inherit)
 		fixed_font = inherit->fixed_font;
 		bold_font = inherit->bold_font;
 		italic_font = inherit->italic_font;
+		retain_font(title_font);
+		retain_font(heading_font);
+		retain_font(text_font);
+		retain_font(fixed_font);
+		retain_font(bold_font);
+		retain_font(italic_font);
 	}		
 	
 	int w, h;
-	TTF_SizeUTF8(text_font, " ", &w, &h);
+	measure_text(text_font, " ", &w, &h);
 	text_space_width = w;
-	TTF_SizeUTF8(fixed_font, " ", &w, &h);
+	measure_text(fixed_font, " ", &w, &h);
 	fixed_space_width = w;
 	
 	title_ascent = TTF_FontAscent(title_font);
@@ -527,9 +549,9 @@ void style::update(dictionary *d)
 	set_font_property(d, "italicfont", &italicfont, &italic_font, textsize);
 	
 	int w, h;		
-	TTF_SizeUTF8(text_font, " ", &w, &h);
+	measure_text(text_font, " ", &w, &h);
 	text_space_width = w;
-	TTF_SizeUTF8(fixed_font, " ", &w, &h);
+	measure_text(fixed_font, " ", &w, &h);
 	fixed_space_width = w;
 	
 	title_ascent = TTF_FontAscent(title_font);
@@ -621,7 +643,7 @@ void style::parse_logo(const char *s)
 	lo->y = atoi(s + comma1 + 1);
 	lo->image_file = new char[strlen(s)];
 	strcpy(lo->image_file, s + comma2 + 1);
-	lo->image = load_png(lo->image_file, 1);
+	lo->image = share_png(lo->image_file, 1, MEM_STYLES);
 	logos->add(lo);
 }
 
@@ -688,12 +710,12 @@ style::style(const char *s, style *inherit)
 	slideborder = 1;
 	barborder = 1;
 
-	// Fonts (filenames):
-	titlefont = TITLE_FONT_FILE;
-	textfont = TEXT_FONT_FILE;
-	fixedfont = FIXED_FONT_FILE;
-	boldfont = BOLD_FONT_FILE;
-	italicfont = ITALIC_FONT_FILE;
+	// Fonts (filenames, owned by the style):
+	titlefont = sdup(TITLE_FONT_FILE);
+	textfont = sdup(TEXT_FONT_FILE);
+	fixedfont = sdup(FIXED_FONT_FILE);
+	boldfont = sdup(BOLD_FONT_FILE);
+	italicfont = sdup(ITALIC_FONT_FILE);
 	
 	// Pictures (filenames):
 	bullet1icon = NULL;
@@ -717,3 +739,52 @@ style::style(const char *s, style *inherit)
 	
 	init_fonts(inherit);
 }
+
+style::~style()
+{
+	logo *lo;
+	
+	delete[] name;
+	
+	release_font(title_font);
+	release_font(heading_font);
+	release_font(text_font);
+	release_font(fixed_font);
+	release_font(bold_font);
+	release_font(italic_font);
+	delete[] titlefont;
+	delete[] textfont;
+	delete[] fixedfont;
+	delete[] boldfont;
+	delete[] italicfont;
+	
+	if(latexinclude != NULL)
+		delete latexinclude;
+	if(latexpreinclude != NULL)
+		delete latexpreinclude;
+	
+	// delete[] on NULL is harmless, release_png() also checks:
+	delete[] bullet1icon;
+	delete[] bullet2icon;
+	delete[] bullet3icon;
+	delete[] bgimage;
+	delete[] bgtexture;
+	delete[] foldcollapsedicon;
+	delete[] foldexpandedicon;
+	release_png(bullet1);
+	release_png(bullet2);
+	release_png(bullet3);
+	release_png(background);
+	release_png(texture);
+	release_png(collapsedicon);
+	release_png(expandedicon);
+	
+	for(int i = 0; i < logos->count(); i++)
+	{
+		lo = logos->item(i);
+		release_png(lo->image);
+		delete[] lo->image_file;
+		delete lo;
+	}
+	delete logos;
+}
@@ -98,6 +98,7 @@ class style
 	logovector *logos;
 	
 	style(const char *name, style *inherit);
+	~style();
 	void update(dictionary *d);
 	
 	private:
@@ -107,5 +108,6 @@ class style
 };
 
 stylevector *load_styles(Config *config);
+void free_styles(stylevector *style_list);
 int get_colour_index(const char *name);
 
@@ -166,7 +166,7 @@ void gen_index(slidevector *talk) // Creates index.html
 	RADAR_MAG = 20;
 	RADAR_WIDTH = (maxx - minx + 1) / RADAR_MAG;
 	RADAR_HEIGHT = (maxy - miny + 1) / RADAR_MAG;	
-	SDL_FreeSurface(radar);
+	free_surface(radar);
 	radar = alloc_surface(RADAR_WIDTH, RADAR_HEIGHT);
 	cx = (minx + maxx) / 2;
 	cy = (miny + maxy) / 2;
@@ -262,7 +262,7 @@ void gen_html(slidevector *talk)
 	RADAR_WIDTH = 200;
 	RADAR_HEIGHT = 100;
 	RADAR_MAG = 20;
-	SDL_FreeSurface(radar);
+	free_surface(radar);
 	radar = alloc_surface(RADAR_WIDTH, RADAR_HEIGHT);
 	
 	sb = new StringBuf();
@@ -352,6 +352,7 @@ void gen_html(slidevector *talk)
 			}
 			
 			// Save image:
+			ensure_rendered(sl);
 			if(sl->render == NULL)
 				error("Tried to export a NULL surface");		
 			ret = SDL_SaveBMP(sl->render, pic_bmp_pathname);